@@ -7,23 +7,78 @@
 #define LOG(x)
 #endif
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
 #include <iostream>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+#include "bulkIO.h"
+#include "parallelAlgorithms.h"
+#include "parallelSort.h"
+#include "radixSort.h"
+#include "relocate.h"
+#include "simdKernels.h"
+#include "span.h"
+
+
+// Construction modes, e.g. Array<double> prices{n, Fill<double>{0.0}, 8}
+struct Uninitialized {}; // trivially copyable T only: skips initialization and never touches the pages
+template<typename V>
+struct Fill { V value; };
+template<typename V>
+struct Iota { V start; }; // start, start + 1, start + 2, ...
+template<typename F>
+struct Generate { F generator; }; // element i = generator(i); must be safe to call from several threads
+template<typename F>
+Generate(F) -> Generate<F>;
+
+// Below this many bytes, spreading initialization over threads costs more than it saves
+constexpr size_t parallelInitThreshold = 1 << 20;
+constexpr size_t pageSize = 4096;
 
 template<typename T>
 class Array {
     T* data;
     size_t s;
+    std::pmr::memory_resource* resource;
 
+        template<typename Init>
+        void initialize(size_t size, unsigned threads, Init init); // init(slot, index) constructs one element
+        template<typename Body>
+        static void forEachChunk(size_t size, unsigned threads, Body body);
+        void allocate(size_t size); // default-initializes, like new T[size]
+        void release();
     public:
         constexpr size_t size() const;
-        Array(size_t size = 1);
+        Array(size_t size = 1, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+        Array(size_t size, Uninitialized, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+        // [threads] > 1 spreads the first touch of every page over that many threads (and so over NUMA nodes)
+        template<typename V>
+        Array(size_t size, Fill<V> fill, unsigned threads = 1, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+        template<typename V>
+        Array(size_t size, Iota<V> iota, unsigned threads = 1, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+        template<typename F>
+        Array(size_t size, Generate<F> generate, unsigned threads = 1, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
         Array(const Array& other);
+        Array(const Array& other, std::pmr::memory_resource* resource);
         Array& operator=(const Array& other);
-        Array(const Array&& other);
-        Array& operator=(const Array&& other);
+        Array(Array&& other);
+        Array& operator=(Array&& other);
+        std::pmr::memory_resource* getResource() const;
         T* getData(); // allows us to memset the memory to a defualt value
         const T* getData() const;
+        Span<T> span() { return Span<T>{data, s}; }
+        Span<const T> span() const { return Span<const T>{data, s}; }
         T& operator[](int index);
         const T& operator[](int index) const;
         T& at(int index);
@@ -33,8 +88,12 @@ class Array {
         T& back();
         const T& back() const;
         bool isEmpty() const;
-        void sort();
+        void sort(); // radix sort for integer and float elements
+        template<typename KeyOf>
+        void sortByKey(KeyOf keyOf); // stable; keyOf(element) returns an integer, float or double
+        void parallelSort(unsigned threads = std::thread::hardware_concurrency());
         void swap(int a, int b);
+        void fill(const T& value, unsigned threads = 1);
 
         typedef T* Iterator;
 
@@ -43,6 +102,20 @@ class Array {
         Iterator rbegin() const { return Iterator{data + s - 1}; }
         Iterator rend() const { return Iterator{data - 1}; }
 
+        // Vectorized (AVX-512/AVX2/SSE4.2, picked at runtime) for arithmetic T, plain loops otherwise
+        Iterator find(const T& value) const;
+        size_t count(const T& value) const;
+        bool contains(const T& value) const;
+        T min() const;
+        T max() const;
+        std::pair<T, T> minmax() const;
+        SumType<T> sum() const;
+        SumType<T> dot(const Array& other) const;
+        // Bulk I/O for integer and float elements: whole buffers at a time, not one operator<< each
+        void writeBinary(const std::string& path, BinaryFormat format = {}) const;
+        void readBinary(const std::string& path, BinaryFormat format = {}); // resizes to the file
+        void writeText(const std::string& path, char separator = '\n') const;
+        void readText(const std::string& path, unsigned threads = 1); // resizes to the file
         template <typename U>
         friend std::ostream& operator<<(std::ostream& out, const Array<U>& arr);
         template <typename U>
@@ -53,43 +126,159 @@ class Array {
 template <typename T>
 constexpr size_t Array<T>::size() const { return s; }
 
+// Splits [0, size) into page-aligned chunks and runs body(begin, end) for each on its own thread.
+// Exceptions from any chunk are rethrown once every thread has finished.
+template <typename T>
+template <typename Body>
+void Array<T>::forEachChunk(size_t size, unsigned threads, Body body) {
+    if (threads <= 1 || size * sizeof(T) < parallelInitThreshold) {
+        body(0, size);
+        return;
+    }
+
+    size_t pageElements = std::max<size_t>(1, pageSize / sizeof(T));
+    size_t chunk = (size / threads + pageElements - 1) / pageElements * pageElements;
+    std::vector<std::thread> workers;
+    std::vector<std::exception_ptr> errors(threads);
+
+    for (unsigned t = 0; t < threads && t * chunk < size; ++t) {
+        size_t begin = t * chunk;
+        size_t end = std::min(size, begin + chunk);
+        workers.emplace_back([&body, &errors, t, begin, end] {
+            try {
+                body(begin, end);
+            } catch (...) {
+                errors[t] = std::current_exception();
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    for (auto& error : errors)
+        if (error) std::rethrow_exception(error);
+}
+
+template <typename T>
+template <typename Init>
+void Array<T>::initialize(size_t size, unsigned threads, Init init) {
+    data = allocateBuffer<T>(size, resource);
+
+    if constexpr (std::is_trivially_destructible<T>::value) { // a failed chunk leaves nothing to destroy
+        try {
+            forEachChunk(size, threads, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) init(&data[i], i);
+            });
+        } catch (...) {
+            deallocateBuffer(data, size, resource);
+            data = nullptr;
+            throw;
+        }
+    } else { // one thread, so we know exactly which elements to destroy if one throws
+        size_t i = 0;
+        try {
+            for (; i < size; ++i) init(&data[i], i);
+        } catch (...) {
+            destroyRange(data, i);
+            deallocateBuffer(data, size, resource);
+            data = nullptr;
+            throw;
+        }
+    }
+    s = size;
+}
+
+template <typename T>
+void Array<T>::allocate(size_t size) {
+    initialize(size, 1, [](T* slot, size_t) { new(slot) T; });
+}
+
+template <typename T>
+void Array<T>::release() {
+    destroyRange(data, s);
+    deallocateBuffer(data, s, resource);
+    data = nullptr;
+    s = 0;
+}
+
+template <typename T>
+Array<T>::Array(size_t size, std::pmr::memory_resource* resource) : data{nullptr}, s{0}, resource{resource} {
+    allocate(size);
+}
+
+template <typename T>
+Array<T>::Array(size_t size, Uninitialized, std::pmr::memory_resource* resource) : data{nullptr}, s{0}, resource{resource} {
+    static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable elements can be left uninitialized");
+    data = allocateBuffer<T>(size, resource);
+    s = size;
+}
+
 template <typename T>
-Array<T>::Array(size_t size) : data{new T[size]}, s{size} {}
+template <typename V>
+Array<T>::Array(size_t size, Fill<V> fill, unsigned threads, std::pmr::memory_resource* resource) :
+    data{nullptr}, s{0}, resource{resource} {
+        T value(fill.value);
+        initialize(size, threads, [&value](T* slot, size_t) { new(slot) T(value); });
+    }
 
 template <typename T>
-Array<T>::Array(const Array& other) : data{new T[other.size()]}, s{s} {
-    for (int i = 0; i < s; ++i) {
-        data[i] = other[i];
+template <typename V>
+Array<T>::Array(size_t size, Iota<V> iota, unsigned threads, std::pmr::memory_resource* resource) :
+    data{nullptr}, s{0}, resource{resource} {
+        initialize(size, threads, [&iota](T* slot, size_t i) { new(slot) T(iota.start + (V) i); });
     }
+
+template <typename T>
+template <typename F>
+Array<T>::Array(size_t size, Generate<F> generate, unsigned threads, std::pmr::memory_resource* resource) :
+    data{nullptr}, s{0}, resource{resource} {
+        initialize(size, threads, [&generate](T* slot, size_t i) { new(slot) T(generate.generator(i)); });
+    }
+
+template <typename T>
+Array<T>::Array(const Array& other) : Array{other, std::pmr::get_default_resource()} {}
+
+template <typename T>
+Array<T>::Array(const Array& other, std::pmr::memory_resource* resource) : data{nullptr}, s{0}, resource{resource} {
+    data = allocateBuffer<T>(other.s, resource);
+    uninitializedCopy(other.data, other.s, data);
+    s = other.s;
 }
 
 template <typename T>
 Array<T>& Array<T>::operator=(const Array& other) {
     if (&other == this) return *this;
 
-    delete[] data;
+    release();
+    data = allocateBuffer<T>(other.s, resource);
+    uninitializedCopy(other.data, other.s, data);
     s = other.s;
-    data = new T[s];
-
-    for (int i = 0; i < s; ++i) {
-        data[i] = other[i];
-    }
 
     return *this;
 }
 
 template <typename T>
-Array<T>::Array(const Array&& other) : data{nullptr}, s{0} {
+Array<T>::Array(Array&& other) : data{nullptr}, s{0}, resource{other.resource} {
     std::swap(s, other.s);
     std::swap(data, other.data);
 }
 
 template <typename T>
-Array<T>& Array<T>::operator=(const Array&& other) {
-    std::swap(s, other.s);
-    std::swap(data, other.data);
+Array<T>& Array<T>::operator=(Array&& other) {
+    if (&other == this) return *this;
+
+    if (resource->is_equal(*other.resource)) {
+        std::swap(s, other.s);
+        std::swap(data, other.data);
+    } else { // can't free the other buffer through our resource, so copy out of it
+        *this = static_cast<const Array&>(other);
+    }
+
+    return *this;
 }
 
+template <typename T>
+std::pmr::memory_resource* Array<T>::getResource() const { return resource; }
+
 template <typename T>
 T* Array<T>::getData() { return data; } // allows us to memset the memory to a defualt value
 template <typename T>
@@ -152,7 +341,90 @@ bool Array<T>::isEmpty() const {
 
 template <typename T>
 void Array<T>::sort() {
-    std::sort(begin(), end());
+    sortRange(begin(), end());
+}
+
+template <typename T>
+template<typename KeyOf>
+void Array<T>::sortByKey(KeyOf keyOf) {
+    radixSortByKey(begin(), end(), keyOf);
+}
+
+template <typename T>
+void Array<T>::parallelSort(unsigned threads) { // falls back to sort() for small arrays
+    ::parallelSort(begin(), end(), threads);
+}
+
+template <typename T>
+typename Array<T>::Iterator Array<T>::find(const T& value) const {
+    return begin() + simdFind(data, s, value);
+}
+
+template <typename T>
+size_t Array<T>::count(const T& value) const {
+    return simdCount(data, s, value);
+}
+
+template <typename T>
+bool Array<T>::contains(const T& value) const {
+    return simdFind(data, s, value) != s;
+}
+
+template <typename T>
+T Array<T>::min() const {
+    return minmax().first;
+}
+
+template <typename T>
+T Array<T>::max() const {
+    return minmax().second;
+}
+
+template <typename T>
+std::pair<T, T> Array<T>::minmax() const {
+    if (s == 0) throw std::out_of_range("Empty array");
+    return simdMinMax(data, s);
+}
+
+template <typename T>
+SumType<T> Array<T>::sum() const {
+    return simdSum(data, s);
+}
+
+template <typename T>
+SumType<T> Array<T>::dot(const Array& other) const {
+    if (other.s != s) throw std::invalid_argument("Size mismatch");
+    return simdDot(data, other.data, s);
+}
+
+template <typename T>
+void Array<T>::writeBinary(const std::string& path, BinaryFormat format) const {
+    ::writeBinary(path, span(), format);
+}
+
+template <typename T>
+void Array<T>::readBinary(const std::string& path, BinaryFormat format) {
+    Array loaded{0, Uninitialized{}, resource}; // a failed read leaves this array as it was
+    ::readBinary<T>(path, format, [&](size_t count) {
+        loaded = Array(count, Uninitialized{}, resource);
+        return loaded.data;
+    });
+    *this = std::move(loaded);
+}
+
+template <typename T>
+void Array<T>::writeText(const std::string& path, char separator) const {
+    ::writeText(path, span(), separator);
+}
+
+template <typename T>
+void Array<T>::readText(const std::string& path, unsigned threads) {
+    Array loaded{0, Uninitialized{}, resource};
+    ::readText<T>(path, threads, [&](size_t count) {
+        loaded = Array(count, Uninitialized{}, resource);
+        return loaded.data;
+    });
+    *this = std::move(loaded);
 }
 
 template <typename T>
@@ -160,6 +432,14 @@ void Array<T>::swap(int a, int b) {
     std::swap(data[a], data[b]);
 }
 
+template <typename T>
+void Array<T>::fill(const T& value, unsigned threads) {
+    T copy(value); // [value] may be one of our own elements
+    forEachChunk(s, std::is_trivially_copyable<T>::value ? threads : 1, [&](size_t begin, size_t end) {
+        std::fill(data + begin, data + end, copy); // vectorized stores (or memset) for trivially copyable T
+    });
+}
+
 template <typename T>
 std::ostream& operator<<(std::ostream& out, const Array<T>& arr) {
     out << '{';
@@ -181,7 +461,434 @@ std::istream& operator>>(std::istream& in, const Array<T>& arr) {
 
 template <typename T>
 Array<T>::~Array() {
-    delete[] data;
+    release();
+}
+
+/* NDArray
+- An Array with a shape: NDArray<T, Rank> maps Rank indices onto one flat Array<T> buffer in
+  row-major, column-major or (for matrices) tiled order
+- NDView is a zero-copy window onto it: a pointer plus a shape and strides per dimension, so
+  slice, transpose and sub-block only rewrite those numbers
+- forEach/fill/sum walk a view in memory order (smallest stride innermost), so contiguous runs
+  reach the SIMD kernels and column-major or transposed data is never walked against the grain
+- assign() copies between views with different orders (e.g. a transpose) in 32x32 blocks, so
+  both sides stay in cache
+*/
+
+enum class Layout { RowMajor, ColumnMajor, Tiled };
+
+constexpr size_t ndBlockSize = 32;
+
+template<typename T, size_t Rank>
+class NDView {
+    static_assert(Rank > 0, "NDView needs at least one dimension");
+
+    T* data;
+    std::array<size_t, Rank> dims;
+    std::array<ptrdiff_t, Rank> steps; // strides in elements
+
+        std::array<size_t, Rank> memoryOrder() const; // dimensions from largest to smallest stride
+        template<typename Run>
+        void forEachRun(Run run) const; // run(pointer, length, stride) for every innermost run
+    public:
+        NDView(T* data, std::array<size_t, Rank> shape, std::array<ptrdiff_t, Rank> strides) : data{data}, dims{shape}, steps{strides} {}
+        size_t shape(size_t dim) const { return dims[dim]; }
+        ptrdiff_t stride(size_t dim) const { return steps[dim]; }
+        size_t size() const;
+        bool isContiguous() const; // no gaps, in some order of the dimensions
+        template<typename... Idx>
+        T& operator()(Idx... idx) const;
+        T& operator[](const std::array<size_t, Rank>& idx) const;
+        T& at(const std::array<size_t, Rank>& idx) const;
+        NDView<T, Rank - 1> slice(size_t dim, size_t index) const; // fixes one index: a row, a column, a plane
+        NDView transpose() const; // reverses the dimensions
+        NDView transpose(size_t a, size_t b) const;
+        NDView subBlock(const std::array<size_t, Rank>& begin, const std::array<size_t, Rank>& end) const;
+        template<typename F>
+        void forEach(F f) const; // f(element&), in memory order
+        void fill(const T& value) const;
+        SumType<std::remove_const_t<T>> sum() const;
+        template<typename U>
+        void assign(const NDView<U, Rank>& other) const; // element-wise copy; shapes must match
+};
+
+template<typename T, size_t Rank>
+size_t NDView<T, Rank>::size() const {
+    size_t n = 1;
+    for (size_t d : dims) n *= d;
+    return n;
+}
+
+template<typename T, size_t Rank>
+std::array<size_t, Rank> NDView<T, Rank>::memoryOrder() const {
+    std::array<size_t, Rank> order;
+    for (size_t d = 0; d < Rank; ++d) order[d] = d;
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return std::abs(steps[a]) > std::abs(steps[b]);
+    });
+    return order;
+}
+
+template<typename T, size_t Rank>
+bool NDView<T, Rank>::isContiguous() const {
+    ptrdiff_t expected = 1;
+    std::array<size_t, Rank> order = memoryOrder();
+    for (size_t i = Rank; i > 0; --i) {
+        size_t d = order[i - 1];
+        if (dims[d] != 1 && steps[d] != expected) return false;
+        expected *= (ptrdiff_t) dims[d];
+    }
+    return true;
+}
+
+template<typename T, size_t Rank>
+template<typename... Idx>
+T& NDView<T, Rank>::operator()(Idx... idx) const {
+    static_assert(sizeof...(Idx) == Rank, "one index per dimension");
+    size_t indices[] = {(size_t) idx...};
+    ptrdiff_t offset = 0;
+    for (size_t d = 0; d < Rank; ++d) offset += (ptrdiff_t) indices[d] * steps[d];
+    return data[offset];
+}
+
+template<typename T, size_t Rank>
+T& NDView<T, Rank>::operator[](const std::array<size_t, Rank>& idx) const {
+    ptrdiff_t offset = 0;
+    for (size_t d = 0; d < Rank; ++d) offset += (ptrdiff_t) idx[d] * steps[d];
+    return data[offset];
+}
+
+template<typename T, size_t Rank>
+T& NDView<T, Rank>::at(const std::array<size_t, Rank>& idx) const {
+    ptrdiff_t offset = 0;
+    for (size_t d = 0; d < Rank; ++d) {
+        if (idx[d] >= dims[d]) throw std::out_of_range("Invalid index");
+        offset += (ptrdiff_t) idx[d] * steps[d];
+    }
+    return data[offset];
+}
+
+template<typename T, size_t Rank>
+NDView<T, Rank - 1> NDView<T, Rank>::slice(size_t dim, size_t index) const {
+    static_assert(Rank > 1, "slicing a 1-D view would leave no dimensions");
+    if (dim >= Rank || index >= dims[dim]) throw std::out_of_range("Invalid index");
+
+    std::array<size_t, Rank - 1> shape;
+    std::array<ptrdiff_t, Rank - 1> strides;
+    for (size_t d = 0, out = 0; d < Rank; ++d) {
+        if (d == dim) continue;
+        shape[out] = dims[d];
+        strides[out++] = steps[d];
+    }
+    return NDView<T, Rank - 1>{data + (ptrdiff_t) index * steps[dim], shape, strides};
+}
+
+template<typename T, size_t Rank>
+NDView<T, Rank> NDView<T, Rank>::transpose() const {
+    NDView result = *this;
+    std::reverse(result.dims.begin(), result.dims.end());
+    std::reverse(result.steps.begin(), result.steps.end());
+    return result;
+}
+
+template<typename T, size_t Rank>
+NDView<T, Rank> NDView<T, Rank>::transpose(size_t a, size_t b) const {
+    if (a >= Rank || b >= Rank) throw std::out_of_range("Invalid index");
+    NDView result = *this;
+    std::swap(result.dims[a], result.dims[b]);
+    std::swap(result.steps[a], result.steps[b]);
+    return result;
+}
+
+template<typename T, size_t Rank>
+NDView<T, Rank> NDView<T, Rank>::subBlock(const std::array<size_t, Rank>& begin, const std::array<size_t, Rank>& end) const {
+    NDView result = *this;
+    for (size_t d = 0; d < Rank; ++d) {
+        if (begin[d] > end[d] || end[d] > dims[d]) throw std::out_of_range("Invalid index");
+        result.data += (ptrdiff_t) begin[d] * steps[d];
+        result.dims[d] = end[d] - begin[d];
+    }
+    return result;
+}
+
+template<typename T, size_t Rank>
+template<typename Run>
+void NDView<T, Rank>::forEachRun(Run run) const {
+    if (size() == 0) return;
+    if (isContiguous()) { // the whole view is one run
+        run(data, size(), 1);
+        return;
+    }
+
+    std::array<size_t, Rank> order = memoryOrder();
+    size_t inner = order[Rank - 1];
+    std::array<size_t, Rank> counter{}; // odometer over the outer dimensions, in memory order
+
+    while (true) {
+        T* base = data;
+        for (size_t i = 0; i + 1 < Rank; ++i) base += (ptrdiff_t) counter[i] * steps[order[i]];
+        run(base, dims[inner], steps[inner]);
+
+        size_t i = Rank - 1;
+        while (i > 0) {
+            --i;
+            if (++counter[i] < dims[order[i]]) break;
+            counter[i] = 0;
+            if (i == 0) return;
+        }
+        if (Rank == 1) return;
+    }
+}
+
+template<typename T, size_t Rank>
+template<typename F>
+void NDView<T, Rank>::forEach(F f) const {
+    forEachRun([&f](T* run, size_t length, ptrdiff_t stride) {
+        if (stride == 1) {
+            for (size_t k = 0; k < length; ++k) f(run[k]); // unit stride: the compiler can vectorize this
+        } else {
+            for (size_t k = 0; k < length; ++k) f(run[(ptrdiff_t) k * stride]);
+        }
+    });
+}
+
+template<typename T, size_t Rank>
+void NDView<T, Rank>::fill(const T& value) const {
+    T copy(value);
+    forEachRun([&copy](T* run, size_t length, ptrdiff_t stride) {
+        if (stride == 1) std::fill(run, run + length, copy);
+        else for (size_t k = 0; k < length; ++k) run[(ptrdiff_t) k * stride] = copy;
+    });
+}
+
+template<typename T, size_t Rank>
+SumType<std::remove_const_t<T>> NDView<T, Rank>::sum() const {
+    typedef std::remove_const_t<T> Value;
+    SumType<Value> total{};
+    forEachRun([&total](T* run, size_t length, ptrdiff_t stride) {
+        if (stride == 1) total += simdSum((const Value*) run, length);
+        else for (size_t k = 0; k < length; ++k) total += (SumType<Value>) run[(ptrdiff_t) k * stride];
+    });
+    return total;
+}
+
+template<typename T, size_t Rank>
+template<typename U>
+void NDView<T, Rank>::assign(const NDView<U, Rank>& other) const {
+    for (size_t d = 0; d < Rank; ++d)
+        if (dims[d] != other.shape(d)) throw std::invalid_argument("Shape mismatch");
+    if (size() == 0) return; // the blocked walk below would still visit index 0 of an empty outer dimension
+
+    std::array<size_t, Rank> order = memoryOrder();
+    size_t inner = order[Rank - 1]; // our fastest dimension
+    size_t otherInner = inner;
+    for (size_t d = 0; d < Rank; ++d)
+        if (std::abs(other.stride(d)) < std::abs(other.stride(otherInner)) && other.shape(d) > 1) otherInner = d;
+
+    std::array<size_t, Rank> idx{};
+    if (Rank == 1 || otherInner == inner) { // both sides agree on the fastest dimension: plain walk
+        forEach([&](T& elem) {
+            elem = other[idx];
+            for (size_t i = Rank; i > 0; --i) {
+                size_t d = order[i - 1];
+                if (++idx[d] < dims[d]) break;
+                idx[d] = 0;
+            }
+        });
+        return;
+    }
+
+    // Different fastest dimensions (a transpose): copy in blocks over the two of them, so the
+    // lines read from [other] are still in cache when the neighbouring lines are written
+    std::array<size_t, Rank> outer{};
+    while (true) {
+        for (size_t a0 = 0; a0 < dims[otherInner]; a0 += ndBlockSize) {
+            for (size_t b0 = 0; b0 < dims[inner]; b0 += ndBlockSize) {
+                size_t a1 = std::min(dims[otherInner], a0 + ndBlockSize);
+                size_t b1 = std::min(dims[inner], b0 + ndBlockSize);
+                for (size_t a = a0; a < a1; ++a) {
+                    for (size_t b = b0; b < b1; ++b) {
+                        idx = outer;
+                        idx[otherInner] = a;
+                        idx[inner] = b;
+                        (*this)[idx] = other[idx];
+                    }
+                }
+            }
+        }
+
+        size_t d = 0; // next combination of the remaining dimensions
+        for (; d < Rank; ++d) {
+            if (d == inner || d == otherInner) continue;
+            if (++outer[d] < dims[d]) break;
+            outer[d] = 0;
+        }
+        if (d == Rank) return;
+    }
+}
+
+template<typename T, size_t Rank>
+class NDArray {
+    Array<T> storage;
+    std::array<size_t, Rank> dims;
+    std::array<ptrdiff_t, Rank> steps; // unused for Tiled
+    Layout arrayLayout;
+    size_t tile;
+
+        static size_t roundUp(size_t n, size_t multiple) { return (n + multiple - 1) / multiple * multiple; }
+        static size_t storageSize(const std::array<size_t, Rank>& shape, Layout layout, size_t tile);
+        size_t offset(const std::array<size_t, Rank>& idx) const;
+    public:
+        NDArray(const std::array<size_t, Rank>& shape, Layout layout = Layout::RowMajor, size_t tile = ndBlockSize,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+        Layout layout() const { return arrayLayout; }
+        size_t shape(size_t dim) const { return dims[dim]; }
+        size_t size() const;
+        T* getData() { return storage.getData(); }
+        const T* getData() const { return storage.getData(); }
+        template<typename... Idx>
+        T& operator()(Idx... idx);
+        template<typename... Idx>
+        const T& operator()(Idx... idx) const;
+        T& at(const std::array<size_t, Rank>& idx);
+        NDView<T, Rank> view(); // throws for Tiled arrays, which have no single stride per dimension
+        NDView<const T, Rank> view() const;
+        NDView<T, Rank - 1> slice(size_t dim, size_t index) { return view().slice(dim, index); }
+        NDView<T, Rank> transpose() { return view().transpose(); }
+        NDView<T, Rank> subBlock(const std::array<size_t, Rank>& begin, const std::array<size_t, Rank>& end) { return view().subBlock(begin, end); }
+        template<typename F>
+        void forEach(F f); // every element once, in storage order
+        void fill(const T& value);
+        SumType<T> sum() const;
+        NDArray toLayout(Layout layout, size_t tile = ndBlockSize) const; // copies in cache-sized blocks
+};
+
+template<typename T, size_t Rank>
+size_t NDArray<T, Rank>::storageSize(const std::array<size_t, Rank>& shape, Layout layout, size_t tile) {
+    if (layout == Layout::Tiled) {
+        if (Rank != 2 || tile == 0) throw std::invalid_argument("Tiled layout needs a 2-D array");
+        return roundUp(shape[0], tile) * roundUp(shape[Rank - 1], tile); // padded to whole tiles
+    }
+
+    size_t n = 1;
+    for (size_t d : shape) n *= d;
+    return n;
+}
+
+template<typename T, size_t Rank>
+NDArray<T, Rank>::NDArray(const std::array<size_t, Rank>& shape, Layout layout, size_t tile, std::pmr::memory_resource* resource) :
+    storage{storageSize(shape, layout, tile), Fill<T>{T{}}, 1, resource}, dims{shape}, steps{}, arrayLayout{layout}, tile{tile} {
+
+        ptrdiff_t stride = 1;
+        if (layout == Layout::ColumnMajor) {
+            for (size_t d = 0; d < Rank; ++d) { steps[d] = stride; stride *= (ptrdiff_t) shape[d]; }
+        } else {
+            for (size_t d = Rank; d > 0; --d) { steps[d - 1] = stride; stride *= (ptrdiff_t) shape[d - 1]; }
+        }
+    }
+
+template<typename T, size_t Rank>
+size_t NDArray<T, Rank>::size() const {
+    size_t n = 1;
+    for (size_t d : dims) n *= d;
+    return n;
+}
+
+template<typename T, size_t Rank>
+size_t NDArray<T, Rank>::offset(const std::array<size_t, Rank>& idx) const {
+    if (arrayLayout == Layout::Tiled) { // tiles in row-major order, each tile row-major inside
+        size_t tilesPerRow = roundUp(dims[Rank - 1], tile) / tile;
+        size_t row = idx[0], col = idx[Rank - 1];
+        return ((row / tile) * tilesPerRow + col / tile) * tile * tile + (row % tile) * tile + col % tile;
+    }
+
+    size_t result = 0;
+    for (size_t d = 0; d < Rank; ++d) result += idx[d] * (size_t) steps[d];
+    return result;
+}
+
+template<typename T, size_t Rank>
+template<typename... Idx>
+T& NDArray<T, Rank>::operator()(Idx... idx) {
+    static_assert(sizeof...(Idx) == Rank, "one index per dimension");
+    return storage.getData()[offset({(size_t) idx...})];
+}
+
+template<typename T, size_t Rank>
+template<typename... Idx>
+const T& NDArray<T, Rank>::operator()(Idx... idx) const {
+    static_assert(sizeof...(Idx) == Rank, "one index per dimension");
+    return storage.getData()[offset({(size_t) idx...})];
+}
+
+template<typename T, size_t Rank>
+T& NDArray<T, Rank>::at(const std::array<size_t, Rank>& idx) {
+    for (size_t d = 0; d < Rank; ++d)
+        if (idx[d] >= dims[d]) throw std::out_of_range("Invalid index");
+    return storage.getData()[offset(idx)];
+}
+
+template<typename T, size_t Rank>
+NDView<T, Rank> NDArray<T, Rank>::view() {
+    if (arrayLayout == Layout::Tiled) throw std::invalid_argument("Tiled arrays have no strided view");
+    return NDView<T, Rank>{storage.getData(), dims, steps};
+}
+
+template<typename T, size_t Rank>
+NDView<const T, Rank> NDArray<T, Rank>::view() const {
+    if (arrayLayout == Layout::Tiled) throw std::invalid_argument("Tiled arrays have no strided view");
+    return NDView<const T, Rank>{storage.getData(), dims, steps};
+}
+
+template<typename T, size_t Rank>
+template<typename F>
+void NDArray<T, Rank>::forEach(F f) {
+    if (arrayLayout != Layout::Tiled) {
+        for (T& elem : storage) f(elem); // flat and unit-stride, whatever the shape
+        return;
+    }
+
+    size_t rows = dims[0], cols = dims[Rank - 1];
+    for (size_t r0 = 0; r0 < rows; r0 += tile) // tile by tile, skipping the padding
+        for (size_t c0 = 0; c0 < cols; c0 += tile)
+            for (size_t r = r0; r < std::min(rows, r0 + tile); ++r) {
+                T* run = &storage.getData()[offset({r, c0})];
+                for (size_t c = 0; c < std::min(tile, cols - c0); ++c) f(run[c]);
+            }
+}
+
+template<typename T, size_t Rank>
+void NDArray<T, Rank>::fill(const T& value) {
+    if (arrayLayout != Layout::Tiled) {
+        storage.fill(value);
+        return;
+    }
+
+    T copy = value; // value may live in this array
+    forEach([&copy](T& elem) { elem = copy; }); // the tile padding must stay T{} for sum()
+}
+
+template<typename T, size_t Rank>
+SumType<T> NDArray<T, Rank>::sum() const {
+    return storage.sum(); // tile padding holds T{} (fill and forEach never touch it), which adds nothing
+}
+
+template<typename T, size_t Rank>
+NDArray<T, Rank> NDArray<T, Rank>::toLayout(Layout layout, size_t tile) const {
+    NDArray result{dims, layout, tile, storage.getResource()};
+
+    if (arrayLayout != Layout::Tiled && layout != Layout::Tiled) {
+        result.view().assign(view()); // blocked copy when the orders differ
+        return result;
+    }
+
+    size_t rows = dims[0], cols = dims[Rank - 1];
+    for (size_t r0 = 0; r0 < rows; r0 += ndBlockSize)
+        for (size_t c0 = 0; c0 < cols; c0 += ndBlockSize)
+            for (size_t r = r0; r < std::min(rows, r0 + ndBlockSize); ++r)
+                for (size_t c = c0; c < std::min(cols, c0 + ndBlockSize); ++c)
+                    result.storage.getData()[result.offset({r, c})] = storage.getData()[offset({r, c})];
+    return result;
 }
 
 void testArrayClass() {
@@ -211,6 +918,67 @@ void testArrayClass() {
 
     std::cout << anotherName;
 
+    std::pmr::unsynchronized_pool_resource pool;
+    Array<std::string> scratch{3, &pool};
+    scratch[0] = "pooled";
+    scratch[1] = "scratch";
+    scratch[2] = "buffer";
+    Array<std::string> scratchCopy{scratch, &pool};
+    scratchCopy.swap(0, 2);
+    std::cout << scratchCopy;
+
+    Array<double> samples{500000};
+    for (size_t i = 0; i < samples.size(); ++i) samples[i] = (double) ((i * 7919) % 500009) / 3;
+    samples.parallelSort(6);
+    LOG("Parallel sort sorted: " << std::is_sorted(samples.begin(), samples.end()))
+
+    Array<long long> offsets{100000};
+    for (size_t i = 0; i < offsets.size(); ++i) offsets[i] = ((long long) i * 7919 % 100003 - 50000) * (1 << 20);
+    offsets.sort(); // radix sort: signed keys need their sign bit flipped
+    LOG("Radix sort sorted: " << std::is_sorted(offsets.begin(), offsets.end()))
+
+    Array<unsigned char> pixels{1000};
+    for (size_t i = 0; i < pixels.size(); ++i) pixels[i] = (unsigned char) (i * 7);
+    LOG("Pixel sum: " << pixels.sum() << ", brightest: " << (int) pixels.max() << ", zeros: " << pixels.count(0))
+
+    Array<double> prices{1 << 18, Fill<double>{1.5}, 4}; // four threads share the first touch of every page
+    LOG("Filled sum: " << prices.sum())
+    prices.fill(0.25, 4);
+    LOG("Refilled sum: " << prices.sum())
+
+    Array<long long> ids{5, Iota<long long>{100}};
+    std::cout << ids;
+    Array<float> ramp{6, Generate{[](size_t i) { return i * 0.5f; }}};
+    std::cout << ramp;
+    Array<std::string> labels{3, Fill<const char*>{"n/a"}};
+    std::cout << labels;
+
+    Array<int> buffer{1 << 20, Uninitialized{}}; // no page is touched until it's written
+    buffer.fill(7);
+    LOG("Buffer count of 7: " << buffer.count(7))
+
+    Span<int> firstHalf = buffer.span().first(buffer.size() / 2); // each worker gets a view, not a copy
+    firstHalf.fill(1);
+    LOG("Buffer sum after half fill: " << buffer.sum())
+    try {
+        firstHalf.subspan(1, firstHalf.size());
+    } catch (const std::out_of_range& e) {
+        LOG("Caught: " << e.what())
+    }
+
+    std::string path = (std::filesystem::temp_directory_path() / "array.test.txt").string();
+    offsets.writeText(path, ' ');
+    Array<long long> loaded;
+    loaded.readText(path, 2);
+    LOG("Text round trip: " << loaded.size() << " offsets, equal: " << std::equal(loaded.begin(), loaded.end(), offsets.begin()))
+    std::filesystem::remove(path);
+
+    Array<long long> runningTotals{ids.size()};
+    parallelScan(ids.span(), runningTotals.span()); // prefix sums: 100, 201, 303, ...
+    std::cout << runningTotals;
+    parallelExclusiveScan(buffer.span(), buffer.span(), 0); // in place: each slot becomes its offset
+    LOG("Offsets scanned in place: " << buffer[1000] << ", last " << buffer.back())
+
    // for (auto& element : names) LOG(element)
 
     std::cout << "Enter three chars: " << std::endl;
@@ -239,6 +1007,54 @@ void testArrayClass() {
     std::cout << nameList;
 }
 
+void testNDArrayClass() {
+    NDArray<int, 2> matrix{{3, 4}}; // row-major 3x4, no hand-written i * cols + j
+    for (size_t i = 0; i < 3; ++i)
+        for (size_t j = 0; j < 4; ++j) matrix(i, j) = (int) (i * 10 + j);
+
+    NDView<int, 2> transposed = matrix.transpose(); // zero-copy: only the strides change
+    LOG("matrix(1, 2) = " << matrix(1, 2) << ", transposed(2, 1) = " << transposed(2, 1))
+
+    NDView<int, 1> column = matrix.slice(1, 3);
+    column.fill(-1);
+    LOG("Column 3 after fill: " << matrix(0, 3) << " " << matrix(1, 3) << " " << matrix(2, 3))
+
+    NDView<int, 2> block = matrix.subBlock({1, 1}, {3, 3});
+    LOG("Sub-block sum: " << block.sum() << ", contiguous: " << block.isContiguous())
+
+    NDArray<int, 2> columnMajor = matrix.toLayout(Layout::ColumnMajor); // blocked copy across orders
+    LOG("Column-major (2, 1) = " << columnMajor(2, 1) << ", second stored element: " << columnMajor.getData()[1])
+
+    NDArray<int, 2> tiled = matrix.toLayout(Layout::Tiled, 2);
+    LOG("Tiled (2, 2) = " << tiled(2, 2) << ", sums agree: " << (tiled.sum() == matrix.sum()))
+    NDArray<int, 2> ones{{3, 4}, Layout::Tiled}; // one 32x32 tile, almost all of it padding
+    ones.fill(1);
+    LOG("Tiled fill sum: " << ones.sum())
+    try {
+        tiled.view();
+    } catch (const std::invalid_argument& e) {
+        LOG("Caught: " << e.what())
+    }
+
+    NDArray<float, 3> volume{{4, 5, 6}, Layout::ColumnMajor};
+    volume.fill(0.5f);
+    volume.slice(2, 0).fill(2.0f); // one 4x5 plane
+    LOG("Volume sum: " << volume.sum() << ", plane sum: " << volume.view().slice(2, 0).sum())
+
+    NDArray<double, 2> big{{300, 200}};
+    size_t n = 0;
+    big.forEach([&n](double& x) { x = (double) n++; });
+    NDArray<double, 2> bigTransposed{{200, 300}};
+    bigTransposed.view().assign(big.transpose()); // 32x32 blocks keep both sides in cache
+    LOG("Transpose copied: " << (bigTransposed(123, 45) == big(45, 123)))
+
+    NDArray<int, 3> cube{{4, 4, 3}};
+    NDArray<int, 3> flat{{0, 4, 4}};
+    flat.view().assign(cube.subBlock({0, 0, 0}, {4, 4, 0}).transpose()); // empty, but still takes the transpose path
+    LOG("Empty transpose copied: " << flat.size())
+}
+
 int main() {
+    testNDArrayClass();
     testArrayClass();
 }
@@ -8,7 +8,14 @@
 #endif
 
 #include <iostream>
+#include <memory_resource>
 #include <queue>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "nodeAllocation.h"
+#include "nodePool.h"
 
 template<typename T>
 class AVLTree {
@@ -20,6 +27,8 @@ class AVLTree {
         BSTNode* right;
     };
 
+    std::pmr::memory_resource* resource; // declared first: deepCopy needs these while root is initialized
+    NodePool nodePool; // every node comes from here; [resource] only supplies its slabs
     BSTNode* root;
     size_t nodeCount;
         // modify these three to updata the parents children and the parents
@@ -36,14 +45,17 @@ class AVLTree {
         BSTNode* BSTremove(const T& elem);
         int height(BSTNode* node) const;
         void clear(BSTNode* node);
+        void releaseNodes();
         BSTNode* deepCopy(BSTNode* other, BSTNode* parent);
         void setHeight(BSTNode* node);
     public:
         AVLTree();
+        explicit AVLTree(std::pmr::memory_resource* resource); // e.g. a per-request arena or a pool
         AVLTree(const AVLTree& other);
         AVLTree(AVLTree&& other);
         AVLTree& operator=(const AVLTree& other);
         AVLTree& operator=(AVLTree&& other);
+        std::pmr::memory_resource* getResource() const;
         void insert(const T& elem);
         bool search(const T& elem);
         bool search(T&& elem);
@@ -129,7 +141,7 @@ typename AVLTree<T>::BSTNode* AVLTree<T>::restructure(BSTNode* x, BSTNode* y, BS
 template <typename T>
 typename AVLTree<T>::BSTNode* AVLTree<T>::BSTinsert(const T& elem) {
     if (!root) {
-        root = new BSTNode{elem, 0, nullptr, nullptr, nullptr};
+        root = createNode<BSTNode>(&nodePool, elem, 0, nullptr, nullptr, nullptr);
         return root;
     }
     BSTNode* node = root;
@@ -138,14 +150,14 @@ typename AVLTree<T>::BSTNode* AVLTree<T>::BSTinsert(const T& elem) {
             return node;
         } else if (node->data < elem) {
             if (!node->right) {
-                node->right = new BSTNode{elem, 0, node, nullptr, nullptr};
+                node->right = createNode<BSTNode>(&nodePool, elem, 0, node, nullptr, nullptr);
                 return node->right;
             } else {
                 node = node->right;
             }
         } else { // elem < node->data
             if (!node->left) {
-                node->left = new BSTNode{elem, 0, node, nullptr, nullptr};
+                node->left = createNode<BSTNode>(&nodePool, elem, 0, node, nullptr, nullptr);
             } else {
                 node = node->left;
             }
@@ -295,7 +307,7 @@ typename AVLTree<T>::BSTNode* AVLTree<T>::BSTremove(const T& elem) {
         }
     }
 
-    delete(toBeDeleted);
+    destroyNode(&nodePool, toBeDeleted);
 
     return node;
 }
@@ -311,22 +323,29 @@ void AVLTree<T>::clear(BSTNode* node) {
     if (node) {
         clear(node->left);
         clear(node->right);
-        delete node;
+        node->~BSTNode(); // the memory goes back with the slabs in releaseNodes
     }
 }
 
+template <typename T>
+void AVLTree<T>::releaseNodes() {
+    if constexpr (!std::is_trivially_destructible<BSTNode>::value) clear(root); // only runs the destructors
+    nodePool.release(); // hands back whole slabs instead of freeing node by node
+    root = nullptr;
+}
+
 template <typename T>
 typename AVLTree<T>::BSTNode* AVLTree<T>::deepCopy(BSTNode* other, BSTNode* parent) {
     if (!other) {
         return nullptr;
     }
-    BSTNode* node = new BSTNode{
+    BSTNode* node = createNode<BSTNode>(&nodePool,
         other->data,
         other->height,
         parent,
         nullptr,
         nullptr
-    };
+    );
 
     if (!root) root = node;
 
@@ -350,20 +369,24 @@ void AVLTree<T>::setHeight(BSTNode* node) {
 }
 
 template <typename T>
-AVLTree<T>::AVLTree() : root{nullptr}, nodeCount{0} {}
+AVLTree<T>::AVLTree() : AVLTree{std::pmr::get_default_resource()} {}
 
 template <typename T>
-AVLTree<T>::AVLTree(const AVLTree& other) : root{deepCopy(other.root, nullptr)}, nodeCount{other.count()} {}
+AVLTree<T>::AVLTree(std::pmr::memory_resource* resource) : resource{resource}, nodePool{sizeof(BSTNode), alignof(BSTNode), resource}, root{nullptr}, nodeCount{0} {}
 
 template <typename T>
-AVLTree<T>::AVLTree(AVLTree&& other) : root{other.root}, nodeCount{other.count()} {
+AVLTree<T>::AVLTree(const AVLTree& other) : resource{std::pmr::get_default_resource()},
+    nodePool{sizeof(BSTNode), alignof(BSTNode), resource}, root{deepCopy(other.root, nullptr)}, nodeCount{other.count()} {}
+
+template <typename T>
+AVLTree<T>::AVLTree(AVLTree&& other) : resource{other.resource}, nodePool{std::move(other.nodePool)}, root{other.root}, nodeCount{other.count()} {
     other.root = nullptr;
 }
 
 template <typename T>
 AVLTree<T>& AVLTree<T>::operator=(const AVLTree& other) {
     nodeCount = other.nodeCount;
-    clear(root);
+    releaseNodes();
     deepCopy(other.root, nullptr);
 
     return *this;
@@ -373,10 +396,15 @@ template <typename T>
 AVLTree<T>& AVLTree<T>::operator=(AVLTree&& other) {
     std::swap(root, other.root);
     std::swap(nodeCount, other.nodeCount);
+    std::swap(resource, other.resource);
+    nodePool.swap(other.nodePool); // the nodes must go back to the pool they came from
 
     return *this;
 }
 
+template <typename T>
+std::pmr::memory_resource* AVLTree<T>::getResource() const { return resource; }
+
 template <typename T>
 void AVLTree<T>::insert(const T& elem) {
     BSTNode* addedNode = BSTinsert(elem);
@@ -706,7 +734,7 @@ int AVLTree<T>::height() const {
 
 template <typename T>
 AVLTree<T>::~AVLTree() {
-    clear(root);
+    releaseNodes();
 }
 
 template<typename T>
@@ -784,6 +812,11 @@ void testAVL() {
 
     myTree4.printLevelOrder(std::cout);
     myTree5.printLevelOrder(std::cout);
+
+    std::pmr::unsynchronized_pool_resource nodePool;
+    AVLTree<int> pooledTree{&nodePool};
+    for (int elem : {1, 2, 3, 4, 5}) pooledTree.insert(elem);
+    pooledTree.printLevelOrder(std::cout);
 }
 
 int main() {
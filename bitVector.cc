@@ -0,0 +1,487 @@
+// C++ Data Structures
+
+#define DEBUG_MODE 1
+#if DEBUG_MODE
+#define LOG(x) std::cout << x << std::endl;
+#else
+#define LOG(x)
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory_resource>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "growthPolicy.h"
+#include "relocate.h"
+#include "simdKernels.h"
+
+/* Bit Vector
+- A growable array of flags packed 64 to a word: one bit per flag instead of the byte that
+  Array<bool> and Vector<bool> spend, so visited/membership sets take an eighth of the memory
+- set/test/flip are a shift and a mask on one word; findFirst/findNext skip whole zero words
+- &=, |=, ^= and andNot run over the words with the SIMD kernels (AVX-512/AVX2/SSE4.2), and
+  count() uses the hardware POPCNT instruction
+- buildRankIndex() adds a two-level count table (about 5% extra) for O(1) rank and
+  O(log n) select, as used by succinct structures. The index goes stale on any change and
+  has to be rebuilt
+- Bits past size() in the last word are always kept zero, so counts and comparisons can work
+  on whole words
+*/
+
+class BitVector {
+    typedef uint64_t Word;
+    static constexpr size_t wordBits = 64;
+    static constexpr size_t blockWords = 8; // rank index: a 16-bit count per 512-bit block...
+    static constexpr size_t superWords = 64; // ...relative to a 64-bit count per 4096-bit superblock
+
+    Word* words;
+    size_t bitCount;
+    size_t wordCapacity;
+    std::pmr::memory_resource* resource;
+    std::vector<uint64_t> superRanks; // ones before each superblock
+    std::vector<uint16_t> blockRanks; // ones before each block, counted from its superblock
+    bool indexValid;
+
+        static size_t wordsFor(size_t bits) { return (bits + wordBits - 1) / wordBits; }
+        static Word bitMask(size_t index) { return Word{1} << (index % wordBits); }
+        static size_t selectInWord(Word word, size_t k); // position of the k-th set bit of [word]
+        size_t wordCount() const { return wordsFor(bitCount); }
+        void clearTail(); // zeroes the bits past size() in the last word
+        void reallocateWords(size_t newCap);
+        void checkSameSize(const BitVector& other) const;
+        template<BitOp Op>
+        BitVector& combine(const BitVector& other);
+    public:
+        class Reference { // what operator[] returns: reads and writes one bit
+            Word* word;
+            Word mask;
+            public:
+                Reference(Word* word, Word mask) : word{word}, mask{mask} {}
+                operator bool() const { return (*word & mask) != 0; }
+                Reference& operator=(bool value) { *word = value ? *word | mask : *word & ~mask; return *this; }
+                Reference& operator=(const Reference& other) { return *this = (bool) other; }
+                void flip() { *word ^= mask; }
+        };
+
+        BitVector();
+        explicit BitVector(std::pmr::memory_resource* resource);
+        BitVector(size_t size, bool value = false, std::pmr::memory_resource* resource = heapResource());
+        BitVector(const BitVector& other);
+        BitVector(const BitVector& other, std::pmr::memory_resource* resource);
+        BitVector(BitVector&& other);
+        BitVector& operator=(const BitVector& other);
+        BitVector& operator=(BitVector&& other);
+        size_t size() const;
+        size_t capacity() const; // in bits
+        size_t sizeBytes() const; // memory used by the bits themselves
+        bool isEmpty() const;
+        std::pmr::memory_resource* getResource() const;
+        Word* getData(); // the packed words, bit i at word i / 64, bit i % 64
+        const Word* getData() const;
+        void reserve(size_t newCap);
+        void resize(size_t newSize, bool value = false);
+        void push_back(bool value);
+        void pop_back();
+        void clear();
+        bool test(size_t index) const;
+        bool operator[](size_t index) const;
+        Reference operator[](size_t index);
+        bool at(size_t index) const;
+        void set(size_t index);
+        void set(size_t index, bool value);
+        void reset(size_t index);
+        void flip(size_t index);
+        void setAll();
+        void resetAll();
+        void flipAll();
+        size_t count() const; // number of set bits
+        bool any() const;
+        bool none() const;
+        bool all() const;
+        size_t findFirst() const; // index of the first set bit, or size() if there is none
+        size_t findNext(size_t index) const; // first set bit after [index], or size()
+        // Word-wise over both vectors, which must be the same size
+        BitVector& operator&=(const BitVector& other);
+        BitVector& operator|=(const BitVector& other);
+        BitVector& operator^=(const BitVector& other);
+        BitVector& andNot(const BitVector& other); // clears every bit that is set in [other]
+        bool operator==(const BitVector& other) const;
+        bool operator!=(const BitVector& other) const;
+        void buildRankIndex();
+        size_t rank(size_t index) const; // set bits in [0, index)
+        size_t select(size_t k) const; // index of the k-th set bit, counting from 0
+        friend std::ostream& operator<<(std::ostream& out, const BitVector& bits);
+        ~BitVector();
+};
+
+size_t BitVector::selectInWord(Word word, size_t k) {
+    for (size_t byte = 0; byte < 8; ++byte) { // skip whole bytes, then walk the one holding the bit
+        size_t ones = (size_t) __builtin_popcountll(word & 0xFF);
+        if (k < ones) {
+            for (; k > 0; --k) word &= word - 1; // drops the lowest set bit
+            return byte * 8 + (size_t) __builtin_ctzll(word);
+        }
+        k -= ones;
+        word >>= 8;
+    }
+    return wordBits;
+}
+
+void BitVector::clearTail() {
+    if (bitCount % wordBits != 0) words[bitCount / wordBits] &= bitMask(bitCount) - 1;
+}
+
+void BitVector::reallocateWords(size_t newCap) {
+    words = reallocateBuffer(words, wordCount(), wordCapacity, newCap, resource);
+    wordCapacity = newCap;
+}
+
+void BitVector::checkSameSize(const BitVector& other) const {
+    if (other.bitCount != bitCount) throw std::invalid_argument("Size mismatch");
+}
+
+template<BitOp Op>
+BitVector& BitVector::combine(const BitVector& other) {
+    checkSameSize(other);
+    simdBitwise<Op>(words, other.words, wordCount());
+    indexValid = false;
+    return *this;
+}
+
+BitVector::BitVector() : BitVector{heapResource()} {}
+
+BitVector::BitVector(std::pmr::memory_resource* resource) :
+    words{nullptr}, bitCount{0}, wordCapacity{0}, resource{resource}, indexValid{false} {}
+
+BitVector::BitVector(size_t size, bool value, std::pmr::memory_resource* resource) : BitVector{resource} {
+    resize(size, value);
+}
+
+// Like Vector, a copy doesn't inherit the source's resource unless asked to
+BitVector::BitVector(const BitVector& other) : BitVector{other, heapResource()} {}
+
+BitVector::BitVector(const BitVector& other, std::pmr::memory_resource* resource) : BitVector{resource} {
+    words = allocateBuffer<Word>(other.wordCount(), resource);
+    wordCapacity = other.wordCount();
+    bitCount = other.bitCount;
+    if (wordCapacity) std::memcpy(words, other.words, wordCapacity * sizeof(Word));
+}
+
+BitVector::BitVector(BitVector&& other) :
+    words{other.words}, bitCount{other.bitCount}, wordCapacity{other.wordCapacity}, resource{other.resource},
+    superRanks{std::move(other.superRanks)}, blockRanks{std::move(other.blockRanks)}, indexValid{other.indexValid} {
+        other.words = nullptr;
+        other.bitCount = 0;
+        other.wordCapacity = 0;
+        other.indexValid = false;
+    }
+
+BitVector& BitVector::operator=(const BitVector& other) {
+    if (this == &other) return *this;
+
+    if (wordCapacity < other.wordCount()) { // reuse the buffer when it's already big enough
+        deallocateBuffer(words, wordCapacity, resource);
+        words = nullptr;
+        wordCapacity = 0;
+        words = allocateBuffer<Word>(other.wordCount(), resource);
+        wordCapacity = other.wordCount();
+    }
+
+    bitCount = other.bitCount;
+    if (bitCount) std::memcpy(words, other.words, wordCount() * sizeof(Word));
+    indexValid = false;
+    return *this;
+}
+
+BitVector& BitVector::operator=(BitVector&& other) {
+    if (this == &other) return *this;
+    if (!resource->is_equal(*other.resource)) return *this = static_cast<const BitVector&>(other);
+
+    std::swap(words, other.words);
+    std::swap(bitCount, other.bitCount);
+    std::swap(wordCapacity, other.wordCapacity);
+    std::swap(superRanks, other.superRanks);
+    std::swap(blockRanks, other.blockRanks);
+    std::swap(indexValid, other.indexValid);
+    return *this;
+}
+
+size_t BitVector::size() const { return bitCount; }
+
+size_t BitVector::capacity() const { return wordCapacity * wordBits; }
+
+size_t BitVector::sizeBytes() const { return wordCount() * sizeof(Word); }
+
+bool BitVector::isEmpty() const { return bitCount == 0; }
+
+std::pmr::memory_resource* BitVector::getResource() const { return resource; }
+
+BitVector::Word* BitVector::getData() { return words; }
+
+const BitVector::Word* BitVector::getData() const { return words; }
+
+void BitVector::reserve(size_t newCap) {
+    if (wordsFor(newCap) > wordCapacity) reallocateWords(wordsFor(newCap));
+}
+
+void BitVector::resize(size_t newSize, bool value) {
+    size_t oldSize = bitCount;
+    size_t oldWords = wordCount();
+    if (wordsFor(newSize) > wordCapacity)
+        reallocateWords(DoublingGrowth::grow(wordCapacity, wordsFor(newSize), sizeof(Word)));
+
+    if (newSize > oldSize) {
+        if (value && oldSize % wordBits != 0) words[oldWords - 1] |= ~(bitMask(oldSize) - 1); // rest of the last word
+        size_t newWords = wordsFor(newSize);
+        if (newWords > oldWords) std::memset(words + oldWords, value ? 0xFF : 0, (newWords - oldWords) * sizeof(Word));
+    }
+
+    bitCount = newSize;
+    clearTail();
+    indexValid = false;
+}
+
+void BitVector::push_back(bool value) {
+    if (bitCount == wordCapacity * wordBits)
+        reallocateWords(DoublingGrowth::grow(wordCapacity, wordCapacity + 1, sizeof(Word)));
+    if (bitCount % wordBits == 0) words[bitCount / wordBits] = 0;
+    if (value) words[bitCount / wordBits] |= bitMask(bitCount);
+    ++bitCount;
+    indexValid = false;
+}
+
+void BitVector::pop_back() {
+    if (bitCount == 0) throw std::out_of_range("Empty array");
+    --bitCount;
+    clearTail();
+    indexValid = false;
+}
+
+void BitVector::clear() {
+    bitCount = 0;
+    indexValid = false;
+}
+
+bool BitVector::test(size_t index) const {
+    return (words[index / wordBits] & bitMask(index)) != 0;
+}
+
+bool BitVector::operator[](size_t index) const {
+    return test(index);
+}
+
+BitVector::Reference BitVector::operator[](size_t index) {
+    indexValid = false;
+    return Reference{&words[index / wordBits], bitMask(index)};
+}
+
+bool BitVector::at(size_t index) const {
+    if (index >= bitCount) {
+        throw std::out_of_range("Invalid index");
+    }
+    return test(index);
+}
+
+void BitVector::set(size_t index) {
+    words[index / wordBits] |= bitMask(index);
+    indexValid = false;
+}
+
+void BitVector::set(size_t index, bool value) {
+    if (value) set(index);
+    else reset(index);
+}
+
+void BitVector::reset(size_t index) {
+    words[index / wordBits] &= ~bitMask(index);
+    indexValid = false;
+}
+
+void BitVector::flip(size_t index) {
+    words[index / wordBits] ^= bitMask(index);
+    indexValid = false;
+}
+
+void BitVector::setAll() {
+    if (bitCount) std::memset(words, 0xFF, sizeBytes());
+    clearTail();
+    indexValid = false;
+}
+
+void BitVector::resetAll() {
+    if (bitCount) std::memset(words, 0, sizeBytes());
+    indexValid = false;
+}
+
+void BitVector::flipAll() {
+    for (size_t i = 0; i < wordCount(); ++i) words[i] = ~words[i];
+    clearTail();
+    indexValid = false;
+}
+
+size_t BitVector::count() const {
+    return simdPopcount(words, wordCount());
+}
+
+bool BitVector::any() const {
+    return findFirst() != bitCount;
+}
+
+bool BitVector::none() const {
+    return !any();
+}
+
+bool BitVector::all() const {
+    return count() == bitCount;
+}
+
+size_t BitVector::findFirst() const {
+    for (size_t i = 0; i < wordCount(); ++i)
+        if (words[i]) return i * wordBits + (size_t) __builtin_ctzll(words[i]);
+    return bitCount;
+}
+
+size_t BitVector::findNext(size_t index) const {
+    if (index + 1 >= bitCount) return bitCount;
+    size_t i = (index + 1) / wordBits;
+    Word word = words[i] & ~(bitMask(index + 1) - 1); // drop the bits up to and including [index]
+    while (true) {
+        if (word) return i * wordBits + (size_t) __builtin_ctzll(word);
+        if (++i == wordCount()) return bitCount;
+        word = words[i];
+    }
+}
+
+BitVector& BitVector::operator&=(const BitVector& other) { return combine<BitOp::And>(other); }
+
+BitVector& BitVector::operator|=(const BitVector& other) { return combine<BitOp::Or>(other); }
+
+BitVector& BitVector::operator^=(const BitVector& other) { return combine<BitOp::Xor>(other); }
+
+BitVector& BitVector::andNot(const BitVector& other) { return combine<BitOp::AndNot>(other); }
+
+bool BitVector::operator==(const BitVector& other) const {
+    return bitCount == other.bitCount && (bitCount == 0 || std::memcmp(words, other.words, sizeBytes()) == 0);
+}
+
+bool BitVector::operator!=(const BitVector& other) const {
+    return !(*this == other);
+}
+
+void BitVector::buildRankIndex() {
+    size_t n = wordCount();
+    superRanks.assign(n / superWords + 1, 0);
+    blockRanks.assign(n / blockWords + 1, 0);
+
+    uint64_t total = 0;
+    uint64_t superStart = 0;
+    for (size_t block = 0; block * blockWords <= n; ++block) {
+        size_t first = block * blockWords;
+        if (first % superWords == 0) {
+            superStart = total;
+            superRanks[first / superWords] = total;
+        }
+        blockRanks[block] = (uint16_t) (total - superStart);
+        total += simdPopcount(words + first, std::min(blockWords, n - first));
+    }
+    indexValid = true;
+}
+
+size_t BitVector::rank(size_t index) const {
+    if (!indexValid) throw std::logic_error("Rank index is out of date");
+    if (index > bitCount) throw std::out_of_range("Invalid index");
+
+    size_t word = index / wordBits;
+    size_t block = word / blockWords;
+    size_t ones = superRanks[word / superWords] + blockRanks[block];
+    for (size_t i = block * blockWords; i < word; ++i) ones += (size_t) __builtin_popcountll(words[i]); // at most 7 words
+    if (index % wordBits) ones += (size_t) __builtin_popcountll(words[word] & (bitMask(index) - 1));
+    return ones;
+}
+
+size_t BitVector::select(size_t k) const {
+    if (!indexValid) throw std::logic_error("Rank index is out of date");
+
+    // Last superblock, then last block within it, with fewer than k + 1 ones before it
+    size_t super = std::upper_bound(superRanks.begin(), superRanks.end(), (uint64_t) k) - superRanks.begin() - 1;
+    size_t firstBlock = super * (superWords / blockWords);
+    size_t lastBlock = std::min(blockRanks.size(), firstBlock + superWords / blockWords);
+    size_t remaining = k - superRanks[super];
+    size_t block = std::upper_bound(blockRanks.begin() + firstBlock + 1, blockRanks.begin() + lastBlock, (uint16_t) remaining) - blockRanks.begin() - 1;
+    remaining -= blockRanks[block];
+
+    for (size_t i = block * blockWords; i < std::min(wordCount(), (block + 1) * blockWords); ++i) {
+        size_t ones = (size_t) __builtin_popcountll(words[i]);
+        if (remaining < ones) return i * wordBits + selectInWord(words[i], remaining);
+        remaining -= ones;
+    }
+    throw std::out_of_range("Invalid index"); // fewer than k + 1 set bits
+}
+
+std::ostream& operator<<(std::ostream& out, const BitVector& bits) {
+    for (size_t i = 0; i < bits.size(); ++i) out << (bits.test(i) ? '1' : '0');
+    out << std::endl;
+    return out;
+}
+
+BitVector::~BitVector() {
+    deallocateBuffer(words, wordCapacity, resource);
+}
+
+void testBitVectorClass() {
+    BitVector flags;
+    for (int i = 0; i < 20; ++i) flags.push_back(i % 3 == 0);
+    std::cout << flags;
+    flags[1] = true;
+    flags.flip(0);
+    flags.reset(3);
+    std::cout << flags;
+    LOG("Set bits: " << flags.count() << ", first: " << flags.findFirst() << ", next after 1: " << flags.findNext(1))
+
+    const size_t vertices = 1000000;
+    BitVector visited{vertices}; // a BFS visited set: 125 KB instead of 1 MB of bools
+    for (size_t v = 0; v < vertices; v += 7) visited.set(v);
+    LOG("Visited: " << visited.count() << " in " << visited.sizeBytes() << " bytes")
+
+    BitVector evens{vertices};
+    for (size_t v = 0; v < vertices; v += 2) evens.set(v);
+    BitVector both = visited;
+    both &= evens; // multiples of 14
+    BitVector either = visited;
+    either |= evens;
+    BitVector oddOnly = visited;
+    oddOnly.andNot(evens);
+    LOG("And: " << both.count() << ", or: " << either.count() << ", and-not: " << oddOnly.count())
+    oddOnly ^= visited;
+    LOG("Xor leaves the common bits: " << (oddOnly == both))
+
+    visited.buildRankIndex();
+    LOG("Rank of 700: " << visited.rank(700) << ", select(100): " << visited.select(100))
+
+    BitVector ones{70, true};
+    ones.flipAll();
+    LOG("All cleared: " << ones.none() << ", size " << ones.size())
+    ones.resize(130, true);
+    LOG("Grown with ones: " << ones.count() << ", all: " << ones.all())
+
+    try {
+        ones.select(0);
+    } catch (const std::logic_error& e) {
+        LOG("Caught: " << e.what())
+    }
+
+    try {
+        both |= flags;
+    } catch (const std::invalid_argument& e) {
+        LOG("Caught: " << e.what())
+    }
+}
+
+int main() {
+    testBitVectorClass();
+}
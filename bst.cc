@@ -8,7 +8,14 @@
 #endif
 
 #include <iostream>
+#include <memory_resource>
 #include <queue>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "nodeAllocation.h"
+#include "nodePool.h"
 
 template<typename T>
 class BinarySearchTree {
@@ -18,6 +25,8 @@ class BinarySearchTree {
         BSTNode* right;
     };
 
+    std::pmr::memory_resource* resource; // declared first: deepCopy needs these while root is initialized
+    NodePool nodePool; // every node comes from here; [resource] only supplies its slabs
     BSTNode* root;
     size_t nodeCount;
 
@@ -31,13 +40,16 @@ class BinarySearchTree {
         BSTNode* remove(BSTNode* node, const T& elem);
         int height(BSTNode* node) const;
         void clear(BSTNode* node);
+        void releaseNodes();
         BSTNode* deepCopy(BSTNode* other);
     public:
         BinarySearchTree();
+        explicit BinarySearchTree(std::pmr::memory_resource* resource); // e.g. a per-request arena or a pool
         BinarySearchTree(const BinarySearchTree& other);
         BinarySearchTree(BinarySearchTree&& other);
         BinarySearchTree& operator=(const BinarySearchTree& other);
         BinarySearchTree& operator=(BinarySearchTree&& other);
+        std::pmr::memory_resource* getResource() const;
         void insert(const T& elem);
         void insert(T&& elem);
         bool search(const T& elem);
@@ -66,9 +78,7 @@ class BinarySearchTree {
 template <typename T>
 typename BinarySearchTree<T>::BSTNode* BinarySearchTree<T>::insert(BSTNode* node, const T& elem) {
     if (!node) {
-        BSTNode* newNode = (BSTNode*) malloc(sizeof(BSTNode));
-        newNode->data = std::move(elem);
-        newNode->left = newNode->right = nullptr;
+        BSTNode* newNode = createNode<BSTNode>(&nodePool, elem, nullptr, nullptr);
         ++nodeCount;
         return newNode;
     }
@@ -150,18 +160,18 @@ typename BinarySearchTree<T>::BSTNode* BinarySearchTree<T>::remove(BSTNode* node
         else {
             if (!node->left && !node->right) {
                 --nodeCount;
-                delete node;
+                destroyNode(&nodePool, node);
                 return nullptr;
             } else if (!node->right) {
                 --nodeCount;
                 BSTNode* toBeDeleted = node;
                 node = node->left;
-                delete toBeDeleted;
+                destroyNode(&nodePool, toBeDeleted);
             } else if (!node->left) {
                 --nodeCount;
                 BSTNode* toBeDeleted = node;
                 node = node->right;
-                delete toBeDeleted;
+                destroyNode(&nodePool, toBeDeleted);
             } else {
                 BSTNode* leftSubtreeMax = node->left;
                 while (leftSubtreeMax->right) leftSubtreeMax = leftSubtreeMax->right;
@@ -186,48 +196,68 @@ void BinarySearchTree<T>::clear(BSTNode* node) {
     if (node) {
         clear(node->left);
         clear(node->right);
-        delete node;
+        node->~BSTNode(); // the memory goes back with the slabs in releaseNodes
     }
 }
 
+template <typename T>
+void BinarySearchTree<T>::releaseNodes() {
+    if constexpr (!std::is_trivially_destructible<BSTNode>::value) clear(root); // only runs the destructors
+    nodePool.release(); // hands back whole slabs instead of freeing node by node
+    root = nullptr;
+}
+
 template <typename T>
 typename BinarySearchTree<T>::BSTNode* BinarySearchTree<T>::deepCopy(BSTNode* other) {
     if (!other) {
         return nullptr;
     }
-    return new BSTNode{
+    return createNode<BSTNode>(&nodePool,
         other->data,
         deepCopy(other->left),
         deepCopy(other->right)
-    };
+    );
 }
 
 template <typename T>
-BinarySearchTree<T>::BinarySearchTree() : root{nullptr}, nodeCount{0} {}
+BinarySearchTree<T>::BinarySearchTree() : BinarySearchTree{std::pmr::get_default_resource()} {}
+
+template <typename T>
+BinarySearchTree<T>::BinarySearchTree(std::pmr::memory_resource* resource) : resource{resource}, nodePool{sizeof(BSTNode), alignof(BSTNode), resource}, root{nullptr}, nodeCount{0} {}
 
 template <typename T>
-BinarySearchTree<T>::BinarySearchTree(const BinarySearchTree& other) : root{deepCopy(other.root)}, nodeCount{other.count()} {}
+BinarySearchTree<T>::BinarySearchTree(const BinarySearchTree& other) : resource{std::pmr::get_default_resource()},
+    nodePool{sizeof(BSTNode), alignof(BSTNode), resource}, root{deepCopy(other.root)}, nodeCount{other.count()} {}
 
 template <typename T>
-BinarySearchTree<T>::BinarySearchTree(BinarySearchTree&& other) : root{other.root}, nodeCount{other.count()} {
+BinarySearchTree<T>::BinarySearchTree(BinarySearchTree&& other) : resource{other.resource}, nodePool{std::move(other.nodePool)}, root{other.root}, nodeCount{other.count()} {
     other.root = nullptr;
 }
 
 template <typename T>
 BinarySearchTree<T>& BinarySearchTree<T>::operator=(const BinarySearchTree& other) {
+    if (this == &other) return *this;
+
+    releaseNodes();
+    root = deepCopy(other.root);
     nodeCount = other.nodeCount;
-    clear();
-    deepCopy(other.root);
+
+    return *this;
 }
 
 template <typename T>
 BinarySearchTree<T>& BinarySearchTree<T>::operator=(BinarySearchTree&& other) {
     std::swap(root, other.root);
     std::swap(nodeCount, other.nodeCount);
+    std::swap(resource, other.resource);
+    nodePool.swap(other.nodePool); // the nodes must go back to the pool they came from
 
     return *this;
 }
 
+template <typename T>
+std::pmr::memory_resource* BinarySearchTree<T>::getResource() const { return resource; }
+
 template <typename T>
 void BinarySearchTree<T>::insert(const T& elem) {
     if (!root) {
@@ -432,7 +462,7 @@ int BinarySearchTree<T>::height() const {
 
 template <typename T>
 BinarySearchTree<T>::~BinarySearchTree() {
-    clear(root);
+    releaseNodes();
 }
 
 void testBST() {
@@ -479,6 +509,13 @@ void testBST() {
     myTree.printPostOrder(std::cout);
     myTree.printLevelOrder(std::cout);
     std::cout << std::endl;
+
+    std::pmr::unsynchronized_pool_resource nodePool;
+    BinarySearchTree<int> pooledTree{&nodePool};
+    for (int elem : {50, 30, 70, 20, 40}) pooledTree.insert(elem);
+    pooledTree.remove(30);
+    pooledTree.printInOrder(std::cout);
+    std::cout << std::endl;
 }
 
 int main() {
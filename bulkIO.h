@@ -0,0 +1,275 @@
+// C++ Data Structures
+
+#ifndef BULK_IO_H
+#define BULK_IO_H
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "radixSort.h"
+#include "span.h"
+
+/* Bulk I/O
+- Reads and writes whole buffers of numbers at once instead of one operator<< / operator>> per
+  element
+- Binary files are the raw element bytes, optionally preceded by a 64-bit element count. Either
+  byte order can be written or read; when it isn't the machine's, the bytes are swapped a chunk at
+  a time
+- Binary reads pread straight into the destination buffer with no intermediate copy
+- Text files are numbers separated by whitespace or commas. Writing formats with std::to_chars
+  into a 1 MiB buffer. Reading maps the file and parses it with std::from_chars, optionally on
+  several threads, each taking a part of the file split at a separator
+- Failed system calls throw std::system_error; malformed files throw std::invalid_argument
+*/
+
+enum class Endian {
+    Little,
+    Big,
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    Native = Big
+#else
+    Native = Little
+#endif
+};
+
+struct BinaryFormat {
+    bool lengthPrefixed = false; // a uint64 element count (in [endian] order) before the data
+    Endian endian = Endian::Native;
+};
+
+constexpr size_t ioChunkBytes = 1 << 20;
+constexpr size_t minTextChunkBytes = 1 << 16; // smaller parts aren't worth a thread
+
+template<typename T>
+constexpr bool isBulkIOType = std::is_arithmetic<T>::value && !std::is_same<T, bool>::value;
+
+inline void checkIO(bool ok, const char* call) {
+    if (!ok) throw std::system_error(errno, std::generic_category(), call);
+}
+
+// Owns a file descriptor for the length of one bulk operation
+struct IOFile {
+    int fd;
+
+    IOFile(const std::string& path, int flags) : fd{open(path.c_str(), flags | O_CLOEXEC, 0644)} { checkIO(fd >= 0, "open"); }
+    IOFile(const IOFile& other) = delete;
+    IOFile& operator=(const IOFile& other) = delete;
+    ~IOFile() { ::close(fd); }
+
+    size_t size() const {
+        struct stat info;
+        checkIO(fstat(fd, &info) == 0, "fstat");
+        return (size_t) info.st_size;
+    }
+};
+
+// write() and pread() may move fewer bytes than asked for, so both loop until they're done
+inline void writeAll(int fd, const void* buffer, size_t bytes) {
+    const char* p = (const char*) buffer;
+    while (bytes > 0) {
+        ssize_t written = write(fd, p, std::min<size_t>(bytes, 1 << 30));
+        if (written < 0 && errno == EINTR) continue;
+        checkIO(written > 0, "write");
+        p += written;
+        bytes -= (size_t) written;
+    }
+}
+
+inline void preadAll(int fd, void* buffer, size_t bytes, off_t offset) {
+    char* p = (char*) buffer;
+    while (bytes > 0) {
+        ssize_t got = pread(fd, p, std::min<size_t>(bytes, 1 << 30), offset);
+        if (got < 0 && errno == EINTR) continue;
+        checkIO(got >= 0, "pread");
+        if (got == 0) throw std::invalid_argument("File is shorter than its header says");
+        p += got;
+        offset += got;
+        bytes -= (size_t) got;
+    }
+}
+
+template<typename T>
+void swapBytes(T* data, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        RadixKey<T> bits;
+        std::memcpy(&bits, &data[i], sizeof(T));
+        if constexpr (sizeof(T) == 2) bits = __builtin_bswap16(bits);
+        if constexpr (sizeof(T) == 4) bits = __builtin_bswap32(bits);
+        if constexpr (sizeof(T) == 8) bits = __builtin_bswap64(bits);
+        std::memcpy(&data[i], &bits, sizeof(T));
+    }
+}
+
+template<typename T>
+void writeBinary(const std::string& path, Span<const T> values, BinaryFormat format = {}) {
+    static_assert(isBulkIOType<T>, "Bulk I/O needs integer or floating-point elements");
+    IOFile file{path, O_WRONLY | O_CREAT | O_TRUNC};
+    bool swap = sizeof(T) > 1 && format.endian != Endian::Native;
+
+    if (format.lengthPrefixed) {
+        uint64_t count = values.size();
+        if (format.endian != Endian::Native) swapBytes(&count, 1);
+        writeAll(file.fd, &count, sizeof(count));
+    }
+
+    if (!swap) {
+        writeAll(file.fd, values.getData(), values.sizeBytes());
+        return;
+    }
+
+    std::vector<T> scratch(std::min(values.size(), ioChunkBytes / sizeof(T)));
+    for (Span<const T> chunk : values.chunks(std::max<size_t>(1, scratch.size()))) {
+        std::copy(chunk.begin(), chunk.end(), scratch.begin());
+        swapBytes(scratch.data(), chunk.size());
+        writeAll(file.fd, scratch.data(), chunk.sizeBytes());
+    }
+}
+
+// Reads a file written by writeBinary. allocate(count) must return room for count elements.
+template<typename T, typename Allocate>
+void readBinary(const std::string& path, BinaryFormat format, Allocate allocate) {
+    static_assert(isBulkIOType<T>, "Bulk I/O needs integer or floating-point elements");
+    IOFile file{path, O_RDONLY};
+    size_t bytes = file.size();
+    off_t offset = 0;
+
+    size_t count = bytes / sizeof(T);
+    if (format.lengthPrefixed) {
+        uint64_t prefix = 0;
+        if (bytes < sizeof(prefix)) throw std::invalid_argument("Not a length-prefixed binary file");
+        preadAll(file.fd, &prefix, sizeof(prefix), 0);
+        if (format.endian != Endian::Native) swapBytes(&prefix, 1);
+        offset = sizeof(prefix);
+        count = (bytes - sizeof(prefix)) / sizeof(T);
+        if (prefix != count || (bytes - sizeof(prefix)) % sizeof(T) != 0)
+            throw std::invalid_argument("Not a binary file of this element type");
+    } else if (bytes % sizeof(T) != 0) {
+        throw std::invalid_argument("Not a binary file of this element type");
+    }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(file.fd, 0, 0, POSIX_FADV_SEQUENTIAL); // only a hint: larger read-ahead
+#endif
+    T* out = allocate(count);
+    preadAll(file.fd, out, count * sizeof(T), offset);
+    if (sizeof(T) > 1 && format.endian != Endian::Native) swapBytes(out, count);
+}
+
+template<typename T>
+void writeText(const std::string& path, Span<const T> values, char separator = '\n') {
+    static_assert(isBulkIOType<T>, "Bulk I/O needs integer or floating-point elements");
+    IOFile file{path, O_WRONLY | O_CREAT | O_TRUNC};
+
+    constexpr size_t maxDigits = 64; // longer than any to_chars output for an arithmetic type
+    std::vector<char> buffer(ioChunkBytes + maxDigits);
+    size_t used = 0;
+    for (const T& value : values) {
+        char* end = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(), value).ptr;
+        *end = separator;
+        used = end + 1 - buffer.data();
+        if (used >= ioChunkBytes) {
+            writeAll(file.fd, buffer.data(), used);
+            used = 0;
+        }
+    }
+    writeAll(file.fd, buffer.data(), used);
+}
+
+inline bool isTextSeparator(char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == ',';
+}
+
+// Parses every number in [first, last) onto the end of [out]
+template<typename T>
+void parseText(const char* first, const char* last, std::vector<T>& out) {
+    const char* p = first;
+    while (p < last) {
+        if (isTextSeparator(*p)) {
+            ++p;
+            continue;
+        }
+
+        T value;
+        auto [next, error] = std::from_chars(p, last, value);
+        if (error != std::errc{} || (next < last && !isTextSeparator(*next)))
+            throw std::invalid_argument("Invalid number: " + std::string(p, std::find_if(p, last, isTextSeparator)));
+        out.push_back(value);
+        p = next;
+    }
+}
+
+// Reads a file written by writeText (or any file of separated numbers). The file is split into
+// [threads] parts at separators, parsed in parallel, then copied into allocate(count) in order.
+template<typename T, typename Allocate>
+void readText(const std::string& path, unsigned threads, Allocate allocate) {
+    static_assert(isBulkIOType<T>, "Bulk I/O needs integer or floating-point elements");
+    IOFile file{path, O_RDONLY};
+    size_t bytes = file.size();
+    if (bytes == 0) {
+        allocate(0);
+        return;
+    }
+
+    void* mapping = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, file.fd, 0);
+    checkIO(mapping != MAP_FAILED, "mmap");
+    struct Unmap {
+        void* mapping;
+        size_t bytes;
+        ~Unmap() { munmap(mapping, bytes); }
+    } unmap{mapping, bytes};
+    madvise(mapping, bytes, MADV_SEQUENTIAL);
+    const char* text = (const char*) mapping;
+
+    size_t parts = std::max<size_t>(1, std::min<size_t>(std::max(threads, 1u), bytes / minTextChunkBytes));
+    std::vector<size_t> bounds(parts + 1, bytes);
+    bounds[0] = 0;
+    for (size_t i = 1; i < parts; ++i) { // move each cut forward to a separator so no number is split
+        size_t cut = std::max(bounds[i - 1], bytes / parts * i);
+        while (cut < bytes && !isTextSeparator(text[cut])) ++cut;
+        bounds[i] = cut;
+    }
+
+    std::vector<std::vector<T>> parsed(parts);
+    std::vector<std::exception_ptr> errors(parts);
+    auto parsePart = [&](size_t i) {
+        try {
+            parsed[i].reserve((bounds[i + 1] - bounds[i]) / 4);
+            parseText(text + bounds[i], text + bounds[i + 1], parsed[i]);
+        } catch (...) {
+            errors[i] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < parts; ++i) workers.emplace_back(parsePart, i);
+    parsePart(0);
+    for (auto& worker : workers) worker.join();
+
+    for (auto& error : errors)
+        if (error) std::rethrow_exception(error);
+
+    size_t count = 0;
+    for (const auto& part : parsed) count += part.size();
+    T* out = allocate(count);
+    for (const auto& part : parsed) {
+        std::copy(part.begin(), part.end(), out);
+        out += part.size();
+    }
+}
+
+#endif
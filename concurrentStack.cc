@@ -0,0 +1,400 @@
+// C++ Data Structures
+
+#define DEBUG_MODE 1
+#if DEBUG_MODE
+#define LOG(x) std::cout << x << std::endl;
+#else
+#define LOG(x)
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/* Concurrent Stack
+- A lock-free Treiber stack: push and try_pop swing the top pointer with one compare-and-swap,
+  so no thread ever waits on a lock held by another
+- Popped nodes aren't freed straight away. They are retired to an epoch-based reclaimer and
+  freed only once every thread that might still be reading them has finished its operation.
+  Because a node's address can't be reused while a popper holds it, the top CAS can't suffer
+  from ABA
+- push_range links its elements into a chain first and publishes the whole chain with one CAS
+- Under contention a failed push or pop visits a random slot of an elimination array, where a
+  push can hand its node straight to a pop; neither touches the top pointer, so contention
+  spreads out instead of piling onto one cache line
+- Nodes come from the global heap rather than a memory resource, because retired nodes may be
+  freed after the stack itself is gone
+*/
+
+// Epoch-based reclamation, shared by every ConcurrentStack.
+// A thread pins the current epoch for the length of one operation. The epoch only advances once
+// every pinned thread has seen it, so memory retired in epoch e is unreachable by epoch e + 2.
+class EpochReclaimer {
+    static constexpr size_t maxThreads = 256;
+    static constexpr size_t collectEvery = 64; // retirements between attempts to free
+
+    struct alignas(64) Participant { // one cache line each, so pinning doesn't false-share
+        std::atomic<uint64_t> state{0}; // 0 when idle, epoch * 2 + 1 while pinned
+        std::atomic<bool> claimed{false};
+    };
+
+    struct Retired {
+        void* object;
+        void (*free)(void*);
+        uint64_t epoch;
+    };
+
+    // Each thread's slot and retired list; handed back to the reclaimer when the thread exits
+    struct ThreadState {
+        EpochReclaimer* reclaimer;
+        size_t slot;
+        std::vector<Retired> retired;
+
+        explicit ThreadState(EpochReclaimer* reclaimer) : reclaimer{reclaimer}, slot{reclaimer->claimSlot()} {}
+        ~ThreadState() { reclaimer->releaseSlot(slot, retired); }
+    };
+
+    std::atomic<uint64_t> epoch{0};
+    Participant participants[maxThreads];
+    std::mutex orphanLock;
+    std::vector<Retired> orphans; // retired by threads that have exited
+
+        size_t claimSlot();
+        void releaseSlot(size_t slot, std::vector<Retired>& retired);
+        bool tryAdvance();
+        void collect(std::vector<Retired>& retired);
+        ThreadState& local();
+    public:
+        class Guard { // pins the epoch until it goes out of scope
+            std::atomic<uint64_t>& state;
+            public:
+                explicit Guard(EpochReclaimer& reclaimer);
+                Guard(const Guard& other) = delete;
+                Guard& operator=(const Guard& other) = delete;
+                ~Guard() { state.store(0, std::memory_order_release); }
+        };
+
+        static EpochReclaimer& instance();
+        void retire(void* object, void (*free)(void*)); // must be unreachable for threads that pin from now on
+        ~EpochReclaimer();
+};
+
+size_t EpochReclaimer::claimSlot() {
+    for (size_t i = 0; i < maxThreads; ++i) {
+        bool expected = false;
+        if (participants[i].claimed.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+            return i;
+    }
+    throw std::runtime_error("Too many threads using concurrent containers");
+}
+
+void EpochReclaimer::releaseSlot(size_t slot, std::vector<Retired>& retired) {
+    {
+        std::lock_guard<std::mutex> guard{orphanLock};
+        orphans.insert(orphans.end(), retired.begin(), retired.end());
+    }
+    retired.clear();
+    participants[slot].state.store(0, std::memory_order_release);
+    participants[slot].claimed.store(false, std::memory_order_release);
+}
+
+bool EpochReclaimer::tryAdvance() {
+    uint64_t current = epoch.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with the fence in Guard
+    for (const Participant& participant : participants) {
+        uint64_t state = participant.state.load(std::memory_order_relaxed);
+        if ((state & 1) && (state >> 1) != current) return false; // someone is still in an older epoch
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return epoch.compare_exchange_strong(current, current + 1, std::memory_order_acq_rel);
+}
+
+void EpochReclaimer::collect(std::vector<Retired>& retired) {
+    tryAdvance();
+    uint64_t safe = epoch.load(std::memory_order_acquire);
+    auto stillNeeded = std::partition(retired.begin(), retired.end(), [safe](const Retired& r) { return r.epoch + 2 > safe; });
+    for (auto it = stillNeeded; it != retired.end(); ++it) it->free(it->object);
+    retired.erase(stillNeeded, retired.end());
+
+    std::unique_lock<std::mutex> guard{orphanLock, std::try_to_lock}; // never wait for it
+    if (guard.owns_lock() && !orphans.empty()) {
+        auto orphansNeeded = std::partition(orphans.begin(), orphans.end(), [safe](const Retired& r) { return r.epoch + 2 > safe; });
+        for (auto it = orphansNeeded; it != orphans.end(); ++it) it->free(it->object);
+        orphans.erase(orphansNeeded, orphans.end());
+    }
+}
+
+EpochReclaimer::ThreadState& EpochReclaimer::local() {
+    thread_local ThreadState state{this};
+    return state;
+}
+
+EpochReclaimer::Guard::Guard(EpochReclaimer& reclaimer) : state{reclaimer.participants[reclaimer.local().slot].state} {
+    state.store(reclaimer.epoch.load(std::memory_order_relaxed) * 2 + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst); // publish the pin before reading any shared pointer
+}
+
+EpochReclaimer& EpochReclaimer::instance() {
+    static EpochReclaimer reclaimer;
+    return reclaimer;
+}
+
+void EpochReclaimer::retire(void* object, void (*free)(void*)) {
+    ThreadState& state = local();
+    state.retired.push_back(Retired{object, free, epoch.load(std::memory_order_acquire)});
+    if (state.retired.size() % collectEvery == 0) collect(state.retired);
+}
+
+EpochReclaimer::~EpochReclaimer() { // every thread has exited by now, so nothing is pinned
+    for (const Retired& r : orphans) r.free(r.object);
+}
+
+template<typename T>
+class ConcurrentStack {
+    struct Node {
+        Node* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+        T* element() { return reinterpret_cast<T*>(storage); }
+    };
+
+    struct alignas(64) Exchanger { // an elimination slot: a pushed node waiting for a pop
+        std::atomic<Node*> offer{nullptr};
+    };
+
+    static constexpr size_t eliminationSlots = 16;
+    static constexpr int eliminationSpins = 128;
+
+    alignas(64) std::atomic<Node*> pTop;
+    Exchanger elimination[eliminationSlots];
+
+        template<typename... args>
+        static Node* makeNode(args&&... myArgs);
+        static void freeNode(void* node) { delete static_cast<Node*>(node); }
+        static size_t randomSlot();
+        static void pause();
+        bool tryEliminatePush(Node* node);
+        Node* tryEliminatePop();
+        T take(Node* node); // moves the value out and retires the node
+    public:
+        ConcurrentStack();
+        ConcurrentStack(const ConcurrentStack& other) = delete;
+        ConcurrentStack& operator=(const ConcurrentStack& other) = delete;
+        void push(const T& elem);
+        void push(T&& elem);
+        template<typename... args>
+        void emplace(args&&... myArgs);
+        template<typename It>
+        void push_range(It first, It last); // one CAS for the whole range; the last element ends on top
+        std::optional<T> try_pop(); // empty when the stack is
+        bool isEmpty() const; // a snapshot: other threads may change it right after
+        ~ConcurrentStack(); // not thread-safe: no other thread may touch the stack meanwhile
+};
+
+template<typename T>
+template<typename... args>
+typename ConcurrentStack<T>::Node* ConcurrentStack<T>::makeNode(args&&... myArgs) {
+    Node* node = new Node;
+    try {
+        new(node->storage) T(std::forward<args>(myArgs)...);
+    } catch (...) {
+        delete node;
+        throw;
+    }
+    return node;
+}
+
+template<typename T>
+size_t ConcurrentStack<T>::randomSlot() {
+    thread_local uint32_t seed = (uint32_t) std::hash<std::thread::id>{}(std::this_thread::get_id()) | 1;
+    seed ^= seed << 13; // xorshift: cheap and per-thread, so no shared state
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed % eliminationSlots;
+}
+
+template<typename T>
+void ConcurrentStack<T>::pause() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// Offers [node] in a random slot and waits briefly for a pop to take it
+template<typename T>
+bool ConcurrentStack<T>::tryEliminatePush(Node* node) {
+    Exchanger& slot = elimination[randomSlot()];
+    Node* empty = nullptr;
+    if (!slot.offer.compare_exchange_strong(empty, node, std::memory_order_release, std::memory_order_relaxed))
+        return false;
+
+    for (int spin = 0; spin < eliminationSpins; ++spin) {
+        if (slot.offer.load(std::memory_order_acquire) != node) return true; // a pop took it
+        pause();
+    }
+
+    Node* expected = node;
+    return !slot.offer.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel); // withdraw, unless just taken
+}
+
+template<typename T>
+typename ConcurrentStack<T>::Node* ConcurrentStack<T>::tryEliminatePop() {
+    Exchanger& slot = elimination[randomSlot()];
+    Node* offered = slot.offer.load(std::memory_order_acquire);
+    if (offered && slot.offer.compare_exchange_strong(offered, nullptr, std::memory_order_acquire, std::memory_order_relaxed))
+        return offered;
+    return nullptr;
+}
+
+template<typename T>
+T ConcurrentStack<T>::take(Node* node) {
+    T value = std::move(*node->element());
+    node->element()->~T();
+    EpochReclaimer::instance().retire(node, freeNode); // a concurrent pop may still be reading node->next
+    return value;
+}
+
+template<typename T>
+ConcurrentStack<T>::ConcurrentStack() : pTop{nullptr} {}
+
+template<typename T>
+void ConcurrentStack<T>::push(const T& elem) {
+    emplace(elem);
+}
+
+template<typename T>
+void ConcurrentStack<T>::push(T&& elem) {
+    emplace(std::move(elem));
+}
+
+template<typename T>
+template<typename... args>
+void ConcurrentStack<T>::emplace(args&&... myArgs) {
+    Node* node = makeNode(std::forward<args>(myArgs)...);
+    EpochReclaimer::Guard guard{EpochReclaimer::instance()}; // an eliminated node must not be recycled while we watch its slot
+
+    Node* top = pTop.load(std::memory_order_relaxed);
+    while (true) {
+        node->next = top;
+        if (pTop.compare_exchange_weak(top, node, std::memory_order_release, std::memory_order_relaxed)) return;
+        if (tryEliminatePush(node)) return;
+        top = pTop.load(std::memory_order_relaxed);
+    }
+}
+
+template<typename T>
+template<typename It>
+void ConcurrentStack<T>::push_range(It first, It last) {
+    if (first == last) return;
+
+    Node* head = nullptr; // built privately, so no other thread sees a half-linked chain
+    Node* tail = nullptr;
+    try {
+        for (; first != last; ++first) {
+            Node* node = makeNode(*first);
+            node->next = head;
+            head = node;
+            if (!tail) tail = node;
+        }
+    } catch (...) {
+        while (head) {
+            Node* next = head->next;
+            head->element()->~T();
+            delete head;
+            head = next;
+        }
+        throw;
+    }
+
+    Node* top = pTop.load(std::memory_order_relaxed);
+    do {
+        tail->next = top;
+    } while (!pTop.compare_exchange_weak(top, head, std::memory_order_release, std::memory_order_relaxed));
+}
+
+template<typename T>
+std::optional<T> ConcurrentStack<T>::try_pop() {
+    EpochReclaimer::Guard guard{EpochReclaimer::instance()}; // keeps [top] alive while we read top->next
+
+    Node* top = pTop.load(std::memory_order_acquire);
+    while (top) {
+        if (pTop.compare_exchange_weak(top, top->next, std::memory_order_acquire, std::memory_order_acquire))
+            return take(top);
+        if (Node* offered = tryEliminatePop()) return take(offered);
+        top = pTop.load(std::memory_order_acquire);
+    }
+    return std::nullopt;
+}
+
+template<typename T>
+bool ConcurrentStack<T>::isEmpty() const {
+    return pTop.load(std::memory_order_acquire) == nullptr;
+}
+
+template<typename T>
+ConcurrentStack<T>::~ConcurrentStack() {
+    Node* node = pTop.load(std::memory_order_acquire);
+    while (node) {
+        Node* next = node->next;
+        node->element()->~T();
+        delete node;
+        node = next;
+    }
+}
+
+void testConcurrentStackClass() {
+    ConcurrentStack<std::string> undo;
+    undo.push("type");
+    undo.emplace(3, 'x');
+    std::vector<std::string> batch{"cut", "paste", "bold"};
+    undo.push_range(batch.begin(), batch.end()); // published with one CAS
+    while (auto action = undo.try_pop()) LOG("Undo " << *action)
+    LOG("Empty: " << undo.isEmpty() << ", pop on empty gives nothing: " << !undo.try_pop().has_value())
+
+    ConcurrentStack<long long> work;
+    const int threads = 8;
+    const int perThread = 100000;
+    std::atomic<long long> poppedSum{0};
+    std::atomic<long long> poppedCount{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            long long sum = 0;
+            long long count = 0;
+            for (int i = 0; i < perThread; ++i) {
+                work.push((long long) t * perThread + i);
+                if (i % 2 == 1) { // pops race with the other threads' pushes
+                    for (int k = 0; k < 2; ++k) {
+                        if (auto value = work.try_pop()) {
+                            sum += *value;
+                            ++count;
+                        }
+                    }
+                }
+            }
+            poppedSum += sum;
+            poppedCount += count;
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    while (auto value = work.try_pop()) {
+        poppedSum += *value;
+        ++poppedCount;
+    }
+    long long n = (long long) threads * perThread;
+    LOG("Popped " << poppedCount << " of " << n << ", sum correct: " << (poppedSum == n * (n - 1) / 2))
+}
+
+int main() {
+    testConcurrentStackClass();
+}
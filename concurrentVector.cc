@@ -0,0 +1,332 @@
+// C++ Data Structures
+
+#define DEBUG_MODE 1
+#if DEBUG_MODE
+#define LOG(x) std::cout << x << std::endl;
+#else
+#define LOG(x)
+#endif
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/* Concurrent Vector
+- An append-only vector that many threads can push_back to at once, without a lock
+- Storage is a fixed table of buckets whose sizes double (8, 16, 32, ...); a full bucket is never
+  copied, a new one is just added, so references and indices stay valid forever
+- push_back reserves its slot with one fetch_add and then constructs in place; only the thread
+  that first touches a new bucket allocates it (losers of that race free their copy)
+- push_back never waits on another pusher, but the first touch of a bucket calls
+  resource->allocate, which may lock or fail; after reserve(n) the first n appends never allocate
+- A bucket whose allocation failed stays empty while later ones fill, so buckets aren't
+  necessarily allocated in order
+- Every slot has a ready flag, so readers can index and iterate while writers are appending;
+  slots still being constructed are skipped
+*/
+
+template<typename T>
+class ConcurrentVector {
+    struct Slot {
+        std::atomic<bool> ready;
+        alignas(T) unsigned char storage[sizeof(T)];
+        T* element() { return reinterpret_cast<T*>(storage); }
+    };
+
+    static constexpr size_t firstBucketBits = 3;
+    static constexpr size_t firstBucketSize = size_t(1) << firstBucketBits;
+    static constexpr size_t bucketCount = 64 - firstBucketBits;
+
+    std::atomic<Slot*> buckets[bucketCount];
+    std::atomic<size_t> reserved;
+    std::pmr::memory_resource* resource; // must be thread-safe, e.g. new_delete or a synchronized_pool_resource
+
+        static size_t bucketSize(size_t bucket) { return firstBucketSize << bucket; }
+
+        // Index i lives in bucket floor(log2(i + 8)) - 3, at i + 8 minus that power of two
+        static size_t bucketOf(size_t index) { return 63 - __builtin_clzll(index + firstBucketSize) - firstBucketBits; }
+        static size_t offsetOf(size_t index, size_t bucket) { return index + firstBucketSize - bucketSize(bucket); }
+
+        Slot* bucketFor(size_t bucket);
+        Slot& slot(size_t index) const;
+        template<typename... args>
+        size_t construct(args&&... myArgs);
+    public:
+        explicit ConcurrentVector(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+        ConcurrentVector(const ConcurrentVector& other) = delete;
+        ConcurrentVector& operator=(const ConcurrentVector& other) = delete;
+        size_t size() const; // slots handed out so far, including ones still being constructed
+        std::pmr::memory_resource* getResource() const;
+        void reserve(size_t newCap); // allocates buckets up front so appends never allocate
+        bool isReady(size_t index) const;
+        T& operator[](size_t index); // index must come from a completed push_back
+        const T& operator[](size_t index) const;
+        T& at(size_t index);
+        const T& at(size_t index) const;
+        size_t push_back(const T& elem); // returns the new element's index
+        size_t push_back(T&& elem);
+        template<typename... args>
+        size_t emplace_back(args&&... myArgs);
+        bool isEmpty() const;
+        void clear(); // not thread-safe: no other thread may touch the vector meanwhile
+
+        class Iterator { // visits ready elements below the size seen when iteration started
+            const ConcurrentVector* v;
+            size_t index;
+            size_t endIndex;
+                void skipUnready() { while (index < endIndex && !v->isReady(index)) ++index; }
+            public:
+                Iterator(const ConcurrentVector* v, size_t index, size_t endIndex) : v{v}, index{index}, endIndex{endIndex} { skipUnready(); }
+                T& operator*() const { return *v->slot(index).element(); }
+                T* operator->() const { return v->slot(index).element(); }
+                Iterator& operator++() { ++index; skipUnready(); return *this; }
+                bool operator==(const Iterator& other) const { return index == other.index; }
+                bool operator!=(const Iterator& other) const { return index != other.index; }
+        };
+        Iterator begin() const { size_t n = size(); return Iterator{this, 0, n}; }
+        Iterator end() const { size_t n = size(); return Iterator{this, n, n}; }
+
+        template <typename U>
+        friend std::ostream& operator<<(std::ostream& out, const ConcurrentVector<U>& v);
+        ~ConcurrentVector();
+};
+
+template<typename T>
+typename ConcurrentVector<T>::Slot* ConcurrentVector<T>::bucketFor(size_t bucket) {
+    Slot* slots = buckets[bucket].load(std::memory_order_acquire);
+    if (slots) return slots;
+
+    size_t count = bucketSize(bucket);
+    Slot* fresh = (Slot*) resource->allocate(sizeof(Slot) * count, alignof(Slot));
+    for (size_t i = 0; i < count; ++i)
+        new(&fresh[i].ready) std::atomic<bool>{false};
+
+    if (buckets[bucket].compare_exchange_strong(slots, fresh, std::memory_order_acq_rel, std::memory_order_acquire))
+        return fresh;
+
+    resource->deallocate(fresh, sizeof(Slot) * count, alignof(Slot)); // another thread installed it first
+    return slots;
+}
+
+template<typename T>
+typename ConcurrentVector<T>::Slot& ConcurrentVector<T>::slot(size_t index) const {
+    size_t bucket = bucketOf(index);
+    return buckets[bucket].load(std::memory_order_acquire)[offsetOf(index, bucket)];
+}
+
+template<typename T>
+template<typename... args>
+size_t ConcurrentVector<T>::construct(args&&... myArgs) {
+    size_t index = reserved.fetch_add(1, std::memory_order_relaxed);
+    size_t bucket = bucketOf(index);
+    Slot& target = bucketFor(bucket)[offsetOf(index, bucket)];
+
+    new(target.storage) T(std::forward<args>(myArgs)...);
+    target.ready.store(true, std::memory_order_release); // publishes the element to readers
+    return index;
+}
+
+template<typename T>
+ConcurrentVector<T>::ConcurrentVector(std::pmr::memory_resource* resource) : reserved{0}, resource{resource} {
+    for (auto& bucket : buckets) bucket.store(nullptr, std::memory_order_relaxed);
+}
+
+template<typename T>
+size_t ConcurrentVector<T>::size() const {
+    return reserved.load(std::memory_order_acquire);
+}
+
+template<typename T>
+std::pmr::memory_resource* ConcurrentVector<T>::getResource() const { return resource; }
+
+template<typename T>
+void ConcurrentVector<T>::reserve(size_t newCap) {
+    if (newCap == 0) return;
+    for (size_t bucket = 0; bucket <= bucketOf(newCap - 1); ++bucket)
+        bucketFor(bucket);
+}
+
+template<typename T>
+bool ConcurrentVector<T>::isReady(size_t index) const {
+    if (index >= size()) return false;
+    size_t bucket = bucketOf(index);
+    Slot* slots = buckets[bucket].load(std::memory_order_acquire);
+    return slots && slots[offsetOf(index, bucket)].ready.load(std::memory_order_acquire);
+}
+
+template<typename T>
+T& ConcurrentVector<T>::operator[](size_t index) {
+    return *slot(index).element();
+}
+
+template<typename T>
+const T& ConcurrentVector<T>::operator[](size_t index) const {
+    return *slot(index).element();
+}
+
+template<typename T>
+T& ConcurrentVector<T>::at(size_t index) {
+    if (!isReady(index)) throw std::out_of_range("Invalid index");
+    return *slot(index).element();
+}
+
+template<typename T>
+const T& ConcurrentVector<T>::at(size_t index) const {
+    if (!isReady(index)) throw std::out_of_range("Invalid index");
+    return *slot(index).element();
+}
+
+template<typename T>
+size_t ConcurrentVector<T>::push_back(const T& elem) {
+    return construct(elem);
+}
+
+template<typename T>
+size_t ConcurrentVector<T>::push_back(T&& elem) { // avoids unnecessary copies
+    return construct(std::move(elem));
+}
+
+template<typename T>
+template<typename... args>
+size_t ConcurrentVector<T>::emplace_back(args&&... myArgs) {
+    return construct(std::forward<args>(myArgs)...);
+}
+
+template<typename T>
+bool ConcurrentVector<T>::isEmpty() const {
+    return size() == 0;
+}
+
+template<typename T>
+void ConcurrentVector<T>::clear() {
+    size_t n = size();
+    if (n == 0) return;
+    for (size_t bucket = 0; bucket <= bucketOf(n - 1); ++bucket) {
+        Slot* slots = buckets[bucket].load(std::memory_order_acquire);
+        if (!slots) continue; // its allocation failed, but later buckets may still hold elements
+
+        size_t count = bucketSize(bucket);
+        for (size_t i = 0; i < count && bucketSize(bucket) - firstBucketSize + i < n; ++i) {
+            if (!std::is_trivially_destructible<T>::value && slots[i].ready.load(std::memory_order_relaxed))
+                slots[i].element()->~T();
+            slots[i].ready.store(false, std::memory_order_relaxed);
+        }
+    }
+    reserved.store(0, std::memory_order_release);
+}
+
+template<typename T>
+std::ostream& operator<<(std::ostream& out, const ConcurrentVector<T>& v) {
+    out << "{";
+    bool first = true;
+    for (const T& elem : v) {
+        if (!first) out << ", ";
+        out << elem;
+        first = false;
+    }
+    out << "}" << std::endl;
+    return out;
+}
+
+template<typename T>
+ConcurrentVector<T>::~ConcurrentVector() {
+    clear();
+    for (size_t bucket = 0; bucket < bucketCount; ++bucket) {
+        Slot* slots = buckets[bucket].load(std::memory_order_relaxed);
+        if (slots) resource->deallocate(slots, sizeof(Slot) * bucketSize(bucket), alignof(Slot));
+    }
+}
+
+// Refuses the next [failures] allocations, to leave a bucket unallocated
+class FailingResource : public std::pmr::memory_resource {
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            if (failures > 0) {
+                --failures;
+                throw std::bad_alloc();
+            }
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        void do_deallocate(void* memory, size_t bytes, size_t alignment) override {
+            std::pmr::new_delete_resource()->deallocate(memory, bytes, alignment);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    public:
+        size_t failures = 0;
+};
+
+void testConcurrentVectorClass() {
+    ConcurrentVector<std::string> names;
+    names.push_back("Amy");
+    names.emplace_back("Carlos");
+    size_t index = names.push_back("Jonathan");
+    std::cout << names;
+    LOG("Index of Jonathan: " << index << ", at(1): " << names.at(1))
+
+    ConcurrentVector<long long> samples;
+    samples.push_back(-1);
+    long long* first = &samples[0]; // never invalidated, however much the vector grows
+
+    const int writers = 4;
+    const int perWriter = 100000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < writers; ++t) {
+        threads.emplace_back([&samples, t] {
+            for (int i = 0; i < perWriter; ++i) samples.push_back((long long) t * perWriter + i);
+        });
+    }
+
+    // Reading while the writers append: every slot handed out must already hold a pushed value,
+    // and each writer's values must show up in the order it pushed them
+    long long n = (long long) writers * perWriter;
+    std::vector<long long> lastFrom(writers, -1);
+    bool consistent = true;
+    size_t position = 0;
+    for (long long sample : samples) {
+        if (position++ == 0) {
+            consistent = consistent && sample == -1;
+        } else if (sample < 0 || sample >= n) {
+            consistent = false; // an unready or torn slot
+        } else {
+            long long& last = lastFrom[sample / perWriter];
+            consistent = consistent && sample > last;
+            last = sample;
+        }
+    }
+    LOG("Reader saw only pushed values, in order: " << consistent)
+
+    for (auto& thread : threads) thread.join();
+
+    long long sum = 0;
+    for (long long sample : samples) sum += sample;
+    LOG("Size: " << samples.size() << ", sum correct: " << (sum == n * (n - 1) / 2 - 1))
+    LOG("First reference stable: " << (first == &samples[0] && *first == -1))
+
+    samples.clear();
+    samples.reserve(1000);
+    LOG("Empty after clear: " << samples.isEmpty())
+
+    FailingResource failing;
+    auto token = std::make_shared<int>(0); // each element holds a reference, so use_count counts the live ones
+    ConcurrentVector<std::shared_ptr<int>> handles{&failing};
+    for (int i = 0; i < 8; ++i) handles.push_back(token); // fills bucket 0
+    failing.failures = 16;
+    for (int i = 0; i < 16; ++i) { // every append to bucket 1 fails, so it's never allocated
+        try {
+            handles.push_back(token);
+        } catch (const std::bad_alloc&) {}
+    }
+    for (int i = 0; i < 10; ++i) handles.push_back(token); // bucket 2, past the gap
+    handles.clear();
+    LOG("Live elements after clear: " << token.use_count() - 1)
+}
+
+int main() {
+    testConcurrentVectorClass();
+}
@@ -0,0 +1,377 @@
+// C++ Data Structures
+
+#define DEBUG_MODE 1
+#if DEBUG_MODE
+#define LOG(x) std::cout << x << std::endl;
+#else
+#define LOG(x)
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "relocate.h"
+
+/* Copy-on-Write Vector
+- Copies share one reference-counted buffer, so copying is O(1) no matter how big the vector is;
+  the refcounts are atomic, so many threads can copy the same published vector at once
+- The buffer is split into fixed-size chunks that are shared separately: the first write to a
+  chunk clones just that chunk (and the small table of chunk pointers), not the whole vector
+- Reads never clone. Writes go through set() and the other mutators, each of which first makes
+  the touched chunk unique to this vector. There is no mutable operator[]: a reference held while
+  the vector is copied would write straight into the copy's shared chunk
+- One vector must not be written by one thread while another thread copies or reads it; publish
+  a finished version and let readers copy that
+*/
+
+template<typename T>
+constexpr size_t defaultChunkSize() {
+    return std::max<size_t>(16, 4096 / sizeof(T));
+}
+
+template<typename T, size_t ChunkSize = defaultChunkSize<T>()>
+class CowVector {
+    struct Chunk { // every chunk but the last is full, so index / ChunkSize finds the chunk
+        size_t count;
+        alignas(T) unsigned char storage[ChunkSize * sizeof(T)];
+
+        Chunk() : count{0} {}
+        Chunk(const Chunk& other) : count{0} {
+            uninitializedCopy(other.data(), other.count, data());
+            count = other.count;
+        }
+        Chunk& operator=(const Chunk& other) = delete;
+        T* data() { return reinterpret_cast<T*>(storage); }
+        const T* data() const { return reinterpret_cast<const T*>(storage); }
+        ~Chunk() { destroyRange(data(), count); }
+    };
+
+    struct Directory {
+        std::vector<std::shared_ptr<Chunk>> chunks;
+        size_t size = 0;
+    };
+
+    std::shared_ptr<Directory> root; // null while empty
+
+        Directory& uniqueDirectory();
+        Chunk& uniqueChunk(size_t chunk);
+        T& mutableElement(size_t index);
+    public:
+        CowVector();
+        CowVector(const CowVector& other); // O(1): shares the chunks
+        CowVector(CowVector&& other);
+        CowVector& operator=(const CowVector& other);
+        CowVector& operator=(CowVector&& other);
+        size_t size() const;
+        bool isShared() const; // true while another copy still refers to our chunks
+        const T& operator[](size_t index) const;
+        const T& at(size_t index) const;
+        void set(size_t index, const T& value); // clones the chunk if it's shared
+        void set(size_t index, T&& value);
+        void push_back(const T& elem);
+        void push_back(T&& elem);
+        template<typename... args>
+        void emplace_back(args&&... myArgs);
+        void pop_back();
+        void insert(const T& elem, size_t n);
+        void erase(size_t n);
+        void clear();
+        const T& front() const;
+        const T& back() const;
+        bool isEmpty() const;
+        void sort();
+        void swap(int a, int b);
+
+        class Iterator { // read-only and random access
+            const CowVector* v;
+            size_t index;
+            public:
+                typedef std::random_access_iterator_tag iterator_category;
+                typedef T value_type;
+                typedef std::ptrdiff_t difference_type;
+                typedef const T* pointer;
+                typedef const T& reference;
+
+                Iterator(const CowVector* v, size_t index) : v{v}, index{index} {}
+                const T& operator*() const { return (*v)[index]; }
+                const T* operator->() const { return &(*v)[index]; }
+                const T& operator[](difference_type n) const { return (*v)[index + n]; }
+                Iterator& operator++() { ++index; return *this; }
+                Iterator operator++(int) { Iterator old = *this; ++index; return old; }
+                Iterator& operator--() { --index; return *this; }
+                Iterator operator--(int) { Iterator old = *this; --index; return old; }
+                Iterator& operator+=(difference_type n) { index += n; return *this; }
+                Iterator& operator-=(difference_type n) { index -= n; return *this; }
+                Iterator operator+(difference_type n) const { return Iterator{v, index + n}; }
+                friend Iterator operator+(difference_type n, const Iterator& it) { return it + n; }
+                Iterator operator-(difference_type n) const { return Iterator{v, index - n}; }
+                difference_type operator-(const Iterator& other) const { return (difference_type) index - (difference_type) other.index; }
+                bool operator==(const Iterator& other) const { return index == other.index; }
+                bool operator!=(const Iterator& other) const { return index != other.index; }
+                bool operator<(const Iterator& other) const { return index < other.index; }
+                bool operator>(const Iterator& other) const { return index > other.index; }
+                bool operator<=(const Iterator& other) const { return index <= other.index; }
+                bool operator>=(const Iterator& other) const { return index >= other.index; }
+        };
+        Iterator begin() const { return Iterator{this, 0}; }
+        Iterator end() const { return Iterator{this, size()}; }
+
+        template <typename U, size_t C>
+        friend std::ostream& operator<<(std::ostream& out, const CowVector<U, C>& v);
+};
+
+template<typename T, size_t ChunkSize>
+typename CowVector<T, ChunkSize>::Directory& CowVector<T, ChunkSize>::uniqueDirectory() {
+    if (!root) root = std::make_shared<Directory>();
+    else if (root.use_count() != 1) root = std::make_shared<Directory>(*root); // copies chunk pointers, not elements
+    else std::atomic_thread_fence(std::memory_order_acquire); // use_count() is relaxed: see the last other owner's reads before writing
+    return *root;
+}
+
+template<typename T, size_t ChunkSize>
+typename CowVector<T, ChunkSize>::Chunk& CowVector<T, ChunkSize>::uniqueChunk(size_t chunk) {
+    std::shared_ptr<Chunk>& shared = uniqueDirectory().chunks[chunk];
+    if (shared.use_count() != 1) shared = std::make_shared<Chunk>(*shared); // first write since the copy
+    else std::atomic_thread_fence(std::memory_order_acquire);
+    return *shared;
+}
+
+template<typename T, size_t ChunkSize>
+T& CowVector<T, ChunkSize>::mutableElement(size_t index) {
+    return uniqueChunk(index / ChunkSize).data()[index % ChunkSize];
+}
+
+template<typename T, size_t ChunkSize>
+CowVector<T, ChunkSize>::CowVector() : root{nullptr} {}
+
+template<typename T, size_t ChunkSize>
+CowVector<T, ChunkSize>::CowVector(const CowVector& other) : root{other.root} {}
+
+template<typename T, size_t ChunkSize>
+CowVector<T, ChunkSize>::CowVector(CowVector&& other) : root{std::move(other.root)} {}
+
+template<typename T, size_t ChunkSize>
+CowVector<T, ChunkSize>& CowVector<T, ChunkSize>::operator=(const CowVector& other) {
+    root = other.root;
+    return *this;
+}
+
+template<typename T, size_t ChunkSize>
+CowVector<T, ChunkSize>& CowVector<T, ChunkSize>::operator=(CowVector&& other) {
+    if (this != &other) root = std::move(other.root);
+    return *this;
+}
+
+template<typename T, size_t ChunkSize>
+size_t CowVector<T, ChunkSize>::size() const { return root ? root->size : 0; }
+
+template<typename T, size_t ChunkSize>
+bool CowVector<T, ChunkSize>::isShared() const { return root && root.use_count() > 1; }
+
+template<typename T, size_t ChunkSize>
+const T& CowVector<T, ChunkSize>::operator[](size_t index) const {
+    return root->chunks[index / ChunkSize]->data()[index % ChunkSize];
+}
+
+template<typename T, size_t ChunkSize>
+const T& CowVector<T, ChunkSize>::at(size_t index) const {
+    if (index >= size()) throw std::out_of_range("Invalid index");
+    return (*this)[index];
+}
+
+template<typename T, size_t ChunkSize>
+void CowVector<T, ChunkSize>::set(size_t index, const T& value) {
+    if (index >= size()) throw std::out_of_range("Invalid index");
+    mutableElement(index) = value;
+}
+
+template<typename T, size_t ChunkSize>
+void CowVector<T, ChunkSize>::set(size_t index, T&& value) {
+    if (index >= size()) throw std::out_of_range("Invalid index");
+    mutableElement(index) = std::move(value);
+}
+
+template<typename T, size_t ChunkSize>
+void CowVector<T, ChunkSize>::push_back(const T& elem) {
+    emplace_back(elem);
+}
+
+template<typename T, size_t ChunkSize>
+void CowVector<T, ChunkSize>::push_back(T&& elem) { // avoids unnecessary copies
+    emplace_back(std::move(elem));
+}
+
+template<typename T, size_t ChunkSize>
+template<typename... args>
+void CowVector<T, ChunkSize>::emplace_back(args&&... myArgs) {
+    Directory& directory = uniqueDirectory();
+    if (directory.size % ChunkSize == 0) directory.chunks.push_back(std::make_shared<Chunk>());
+
+    Chunk& last = uniqueChunk(directory.chunks.size() - 1);
+    new(&last.data()[last.count]) T(std::forward<args>(myArgs)...);
+    ++last.count;
+    ++directory.size;
+}
+
+template<typename T, size_t ChunkSize>
+void CowVector<T, ChunkSize>::pop_back() {
+    if (size() == 0) throw std::out_of_range("Empty array");
+
+    Directory& directory = uniqueDirectory();
+    if (directory.chunks.back()->count == 1) { // dropping our reference is enough, even if the chunk is shared
+        directory.chunks.pop_back();
+    } else {
+        Chunk& last = uniqueChunk(directory.chunks.size() - 1);
+        --last.count;
+        last.data()[last.count].~T();
+    }
+    --directory.size;
+}
+
+template<typename T, size_t ChunkSize>
+void CowVector<T, ChunkSize>::insert(const T& elem, size_t n) {
+    if (n > size()) {
+        throw std::out_of_range("Invalid index");
+    }
+
+    T value = elem; // [elem] may be one of our own elements
+    push_back(value);
+    for (size_t i = size() - 1; i > n; --i) // only the chunks from [n] onwards get cloned
+        mutableElement(i) = std::move(mutableElement(i - 1));
+    mutableElement(n) = std::move(value);
+}
+
+template<typename T, size_t ChunkSize>
+void CowVector<T, ChunkSize>::erase(size_t n) {
+    if (n >= size()) {
+        throw std::out_of_range("Invalid index");
+    }
+
+    for (size_t i = n; i + 1 < size(); ++i)
+        mutableElement(i) = std::move(mutableElement(i + 1));
+    pop_back();
+}
+
+template<typename T, size_t ChunkSize>
+void CowVector<T, ChunkSize>::clear() {
+    root.reset(); // other copies keep their chunks alive
+}
+
+template<typename T, size_t ChunkSize>
+const T& CowVector<T, ChunkSize>::front() const {
+    if (size() == 0) throw std::out_of_range("Empty array");
+    return (*this)[0];
+}
+
+template<typename T, size_t ChunkSize>
+const T& CowVector<T, ChunkSize>::back() const {
+    if (size() == 0) throw std::out_of_range("Empty array");
+    return (*this)[size() - 1];
+}
+
+template<typename T, size_t ChunkSize>
+bool CowVector<T, ChunkSize>::isEmpty() const {
+    return size() == 0;
+}
+
+template<typename T, size_t ChunkSize>
+void CowVector<T, ChunkSize>::sort() {
+    std::vector<T> sorted(begin(), end());
+    std::sort(sorted.begin(), sorted.end());
+
+    CowVector result; // fresh, unshared chunks
+    for (T& elem : sorted) result.push_back(std::move(elem));
+    *this = std::move(result);
+}
+
+template<typename T, size_t ChunkSize>
+void CowVector<T, ChunkSize>::swap(int a, int b) {
+    std::swap(mutableElement(a), mutableElement(b));
+}
+
+template<typename T, size_t ChunkSize>
+std::ostream& operator<<(std::ostream& out, const CowVector<T, ChunkSize>& v) {
+    out << "{";
+    for (size_t i = 0; i < v.size(); ++i) {
+        out << v[i];
+        if (i != v.size() - 1) out << ", ";
+    }
+    out << "}" << std::endl;
+    return out;
+}
+
+void testCowVectorClass() {
+    CowVector<std::string, 4> routes;
+    routes.push_back("eu-west");
+    routes.push_back("us-east");
+    routes.emplace_back("ap-south");
+    routes.push_back("us-west");
+    routes.push_back("sa-east");
+    std::cout << routes;
+
+    CowVector<std::string, 4> snapshot{routes}; // O(1): nothing is copied yet
+    LOG("Shared after copy: " << snapshot.isShared())
+
+    routes.set(4, "af-south"); // clones only the second chunk
+    routes.set(0, routes[0] + "-1");
+    std::cout << routes << snapshot;
+
+    routes.insert("me-central", 1);
+    routes.erase(3);
+    routes.swap(0, 1);
+    std::cout << routes;
+    routes.sort();
+    std::cout << routes;
+    LOG("Front: " << routes.front() << ", back: " << routes.back() << ", at(1): " << routes.at(1))
+
+    routes.pop_back();
+    routes.clear();
+    LOG("Cleared: " << routes.isEmpty() << ", snapshot untouched: " << snapshot.size())
+
+    CowVector<long long> table;
+    for (long long i = 0; i < 1000000; ++i) table.push_back(i);
+
+    CowVector<long long> edited{table};
+    edited.set(500000, -1); // one chunk cloned, the other ~1950 still shared
+    const CowVector<long long>& published = table;
+    LOG("Unedited chunks shared: " << (&table[0] == &edited[0]) << ", edited chunk cloned: " << (&table[500000] != &edited[500000]))
+    LOG("Original value kept: " << table.at(500000))
+
+    std::vector<std::thread> subscribers;
+    std::vector<long long> sums(4, 0);
+    for (int t = 0; t < 4; ++t) {
+        subscribers.emplace_back([&published, &sums, t] {
+            CowVector<long long> mine{published}; // concurrent O(1) copies of one published version
+            for (long long value : mine) sums[t] += value;
+        });
+    }
+    for (auto& subscriber : subscribers) subscriber.join();
+    LOG("Subscribers agree: " << (sums[0] == sums[3] && sums[0] == 999999LL * 1000000 / 2))
+
+    CowVector<long long> ledger;
+    for (long long i = 0; i < 10000; ++i) ledger.push_back(i);
+    long long borrowedSum = 0;
+    CowVector<long long> borrowed{ledger};
+    std::thread borrower([&borrowedSum, borrowed = std::move(borrowed)] {
+        for (long long value : borrowed) borrowedSum += value;
+    }); // the copy is dropped on the borrower's thread, once it has read every chunk
+    while (ledger.isShared()) std::this_thread::yield();
+    ledger.set(0, -1); // sole owner again, so this writes in place, after the borrower's reads
+    borrower.join();
+    LOG("Borrower read the old version: " << (borrowedSum == 9999LL * 10000 / 2) << ", ledger now starts at: " << ledger[0])
+
+    auto middle = std::lower_bound(table.begin(), table.end(), 750000LL); // needs a real random access iterator
+    LOG("Binary search found: " << *middle << " at " << middle - table.begin() << ", next: " << middle[1])
+}
+
+int main() {
+    testCowVectorClass();
+}
@@ -8,6 +8,13 @@
 #endif
 
 #include <iostream>
+#include <memory_resource>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "nodeAllocation.h"
+#include "nodePool.h"
 
 
 /* Doubly Linked List
@@ -25,13 +32,17 @@ class DoublyLinkedList {
     Node* pHead;
     Node* pTail;
     size_t size;
+    std::pmr::memory_resource* resource;
+    NodePool nodePool; // every node comes from here; [resource] only supplies its slabs
 
     public:
         DoublyLinkedList();
+        explicit DoublyLinkedList(std::pmr::memory_resource* resource); // e.g. a per-request arena or a pool
         DoublyLinkedList(const DoublyLinkedList& other);
         DoublyLinkedList(DoublyLinkedList&& other);
         DoublyLinkedList& operator=(const DoublyLinkedList& other);
         DoublyLinkedList& operator=(DoublyLinkedList&& other);
+        std::pmr::memory_resource* getResource() const;
         
         constexpr size_t length() const noexcept;
         T& head();
@@ -78,23 +89,27 @@ class DoublyLinkedList {
 };
 
 template<typename T>
-DoublyLinkedList<T>::DoublyLinkedList() : pHead{nullptr}, pTail{nullptr}, size{0} {}
+DoublyLinkedList<T>::DoublyLinkedList() : DoublyLinkedList{std::pmr::get_default_resource()} {}
+
+template<typename T>
+DoublyLinkedList<T>::DoublyLinkedList(std::pmr::memory_resource* resource) : pHead{nullptr}, pTail{nullptr}, size{0}, resource{resource}, nodePool{sizeof(Node), alignof(Node), resource} {}
 
 template<typename T>
-DoublyLinkedList<T>::DoublyLinkedList(const DoublyLinkedList& other) : pHead{nullptr}, pTail{nullptr}, size{0} {
+DoublyLinkedList<T>::DoublyLinkedList(const DoublyLinkedList& other) : pHead{nullptr}, pTail{nullptr}, size{0}, resource{std::pmr::get_default_resource()},
+    nodePool{sizeof(Node), alignof(Node), resource} {
     Node* otherTraverser = other.pHead;
     Node* thisTraverser = nullptr;
     Node* thisNextTraverser = nullptr;
 
     if (otherTraverser) {
-        pHead = new Node{otherTraverser->data, nullptr, nullptr};
+        pHead = createNode<Node>(&nodePool, otherTraverser->data, nullptr, nullptr);
         thisTraverser = pHead;
     }
 
     while (otherTraverser) {
         ++size;
         otherTraverser = otherTraverser->next;
-        thisNextTraverser = otherTraverser? new Node{otherTraverser->data, nullptr, thisTraverser} : otherTraverser;
+        thisNextTraverser = otherTraverser? createNode<Node>(&nodePool, otherTraverser->data, nullptr, thisTraverser) : otherTraverser;
         thisTraverser->next = thisNextTraverser;
         if (thisNextTraverser) thisTraverser = thisTraverser->next;
     }
@@ -103,7 +118,7 @@ DoublyLinkedList<T>::DoublyLinkedList(const DoublyLinkedList& other) : pHead{nul
 }
 
 template<typename T>
-DoublyLinkedList<T>::DoublyLinkedList(DoublyLinkedList&& other) : pHead{other.pHead}, pTail{other.pTail}, size{other.size} {
+DoublyLinkedList<T>::DoublyLinkedList(DoublyLinkedList&& other) : pHead{other.pHead}, pTail{other.pTail}, size{other.size}, resource{other.resource}, nodePool{std::move(other.nodePool)} {
     other.pHead = nullptr;
     other.pTail = nullptr;
     other.size = 0;
@@ -119,14 +134,14 @@ DoublyLinkedList<T>& DoublyLinkedList<T>::operator=(const DoublyLinkedList& othe
     Node* thisNextTraverser = nullptr;
 
     if (otherTraverser) {
-        pHead = new Node{otherTraverser->data, nullptr, nullptr};
+        pHead = createNode<Node>(&nodePool, otherTraverser->data, nullptr, nullptr);
         thisTraverser = pHead;
     }
 
     while (otherTraverser) {
         ++size;
         otherTraverser = otherTraverser->next;
-        thisNextTraverser = otherTraverser? new Node{otherTraverser->data, nullptr, thisTraverser} : otherTraverser;
+        thisNextTraverser = otherTraverser? createNode<Node>(&nodePool, otherTraverser->data, nullptr, thisTraverser) : otherTraverser;
         thisTraverser->next = thisNextTraverser;
         if (thisNextTraverser) thisTraverser = thisTraverser->next;
     }
@@ -141,10 +156,15 @@ DoublyLinkedList<T>& DoublyLinkedList<T>::operator=(DoublyLinkedList&& other) {
     std::swap(pHead, other.pHead);
     std::swap(pTail, other.pTail);
     std::swap(size, other.size);
+    std::swap(resource, other.resource);
+    nodePool.swap(other.nodePool); // the nodes must go back to the pool they came from
 
     return *this;
 }
 
+template<typename T>
+std::pmr::memory_resource* DoublyLinkedList<T>::getResource() const { return resource; }
+
 template<typename T>
 constexpr size_t DoublyLinkedList<T>::length() const noexcept { return size; }
 
@@ -174,21 +194,21 @@ const T& DoublyLinkedList<T>::tail() const {
 
 template<typename T>
 void DoublyLinkedList<T>::add_to_front(const T& elem) {
-    Node* newNode = new Node{elem, pHead, nullptr};
+    Node* newNode = createNode<Node>(&nodePool, elem, pHead, nullptr);
     pHead = newNode;
     ++size;
 }
 
 template<typename T>
 void DoublyLinkedList<T>::add_to_front(T&& elem) {
-    Node* newNode = new Node{std::move(elem), pHead, nullptr};
+    Node* newNode = createNode<Node>(&nodePool, std::move(elem), pHead, nullptr);
     pHead = newNode;
     ++size;
 }
 
 template<typename T>
 void DoublyLinkedList<T>::push_back(const T& elem) {
-    Node* newNode = new Node{elem, nullptr, pTail};
+    Node* newNode = createNode<Node>(&nodePool, elem, nullptr, pTail);
 
     if (size == 0) {
         pHead = newNode;
@@ -203,7 +223,7 @@ void DoublyLinkedList<T>::push_back(const T& elem) {
 
 template<typename T>
 void DoublyLinkedList<T>::push_back(T&& elem) {
-    Node* newNode = new Node{std::move(elem), nullptr, pTail};
+    Node* newNode = createNode<Node>(&nodePool, std::move(elem), nullptr, pTail);
 
     if (size == 0) {
         pHead = newNode;
@@ -229,7 +249,7 @@ void DoublyLinkedList<T>::insert(const T& elem, size_t index) {
         ++i;
     }
 
-    Node* newNode = new Node{elem, traverser->next, traverser};
+    Node* newNode = createNode<Node>(&nodePool, elem, traverser->next, traverser);
     traverser->next = newNode;
 
     ++size;
@@ -248,7 +268,7 @@ void DoublyLinkedList<T>::insert(T&& elem, size_t index) {
         ++i;
     }
 
-    Node* newNode = new Node{std::move(elem), traverser->next, traverser};
+    Node* newNode = createNode<Node>(&nodePool, std::move(elem), traverser->next, traverser);
     traverser->next = newNode;
 
     ++size;
@@ -278,7 +298,7 @@ void DoublyLinkedList<T>::erase(int index) {
     }
 
     --size;
-    delete toBeDeleted;
+    destroyNode(&nodePool, toBeDeleted);
 }
 
 template<typename T>
@@ -422,14 +442,11 @@ void DoublyLinkedList<T>::reverse() {
 
 template<typename T>
 void DoublyLinkedList<T>::clear() {
-    Node* traverser = pHead;
-    Node* tempNode = nullptr;
-
-    while(traverser) {
-        tempNode = traverser->next;
-        delete traverser;
-        traverser = tempNode;
+    if constexpr (!std::is_trivially_destructible<T>::value) {
+        for (Node* traverser = pHead; traverser; traverser = traverser->next)
+            traverser->data.~T();
     }
+    nodePool.release(); // hands back whole slabs instead of freeing node by node
 
     size = 0;
     pHead = nullptr;
@@ -438,14 +455,11 @@ void DoublyLinkedList<T>::clear() {
 
 template<typename T>
 DoublyLinkedList<T>::~DoublyLinkedList() {
-    Node* traverser = pHead;
-    Node* tempNode = nullptr;
-
-    while(traverser) {
-        tempNode = traverser->next;
-        delete traverser;
-        traverser = tempNode;
+    if constexpr (!std::is_trivially_destructible<T>::value) {
+        for (Node* traverser = pHead; traverser; traverser = traverser->next)
+            traverser->data.~T();
     }
+    // nodePool hands back whole slabs when it's destroyed
 }
 
 template<typename T>
@@ -540,6 +554,12 @@ void testDoublyLinkedList() {
     for (auto it = friends3.rbegin(); it != friends3.rend(); --it) {
         LOG(*it)
     }
+
+    std::pmr::monotonic_buffer_resource requestArena;
+    DoublyLinkedList<std::string> arenaFriends{&requestArena};
+    arenaFriends.push_back("Maya");
+    arenaFriends.add_to_front("Omar");
+    std::cout << arenaFriends << std::endl;
 }
 
 int main() {
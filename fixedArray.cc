@@ -0,0 +1,236 @@
+// C++ Data Structures
+
+#define DEBUG_MODE 1
+#if DEBUG_MODE
+#define LOG(x) std::cout << x << std::endl;
+#else
+#define LOG(x)
+#endif
+
+#include <cstdint>
+#include <initializer_list>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "radixSort.h"
+#include "span.h"
+
+/* Fixed Array
+- An Array whose size is a template parameter, so the elements live inside the object itself:
+  on the stack, in another object, or in static storage, never on the heap
+- Everything is constexpr, so lookup tables can be filled, sorted and searched at compile time
+  and cost nothing at startup
+- sort() uses a constexpr heap sort at compile time and the radix/std::sort path at runtime
+*/
+
+// Swaps without std::swap, which isn't constexpr until C++20
+template<typename T>
+constexpr void constexprSwap(T& a, T& b) {
+    T temp = std::move(a);
+    a = std::move(b);
+    b = std::move(temp);
+}
+
+template<typename T>
+constexpr void siftDown(T* data, size_t root, size_t size) {
+    while (2 * root + 1 < size) {
+        size_t child = 2 * root + 1;
+        if (child + 1 < size && data[child] < data[child + 1]) ++child;
+        if (!(data[root] < data[child])) return;
+        constexprSwap(data[root], data[child]);
+        root = child;
+    }
+}
+
+// Heap sort: O(n log n), no recursion and no allocation, so it runs inside constant evaluation
+template<typename T>
+constexpr void constexprSort(T* data, size_t size) {
+    for (size_t i = size / 2; i > 0; --i) siftDown(data, i - 1, size);
+    for (size_t end = size; end > 1; --end) {
+        constexprSwap(data[0], data[end - 1]);
+        siftDown(data, 0, end - 1);
+    }
+}
+
+template<typename T, size_t N>
+class FixedArray {
+    static_assert(N > 0, "FixedArray needs at least one element");
+
+    T data[N];
+    public:
+        constexpr FixedArray() : data{} {}
+        constexpr FixedArray(std::initializer_list<T> values); // any elements not given are value-initialized
+        static constexpr size_t size() { return N; }
+        constexpr T* getData() { return data; }
+        constexpr const T* getData() const { return data; }
+        constexpr Span<T> span() { return Span<T>{data, N}; }
+        constexpr Span<const T> span() const { return Span<const T>{data, N}; }
+        constexpr T& operator[](size_t index) { return data[index]; }
+        constexpr const T& operator[](size_t index) const { return data[index]; }
+        constexpr T& at(size_t index);
+        constexpr const T& at(size_t index) const;
+        constexpr T& front() { return data[0]; }
+        constexpr const T& front() const { return data[0]; }
+        constexpr T& back() { return data[N - 1]; }
+        constexpr const T& back() const { return data[N - 1]; }
+        constexpr bool isEmpty() const { return false; }
+        constexpr void fill(const T& value);
+        constexpr void sort();
+        constexpr void swap(size_t a, size_t b);
+        constexpr bool contains(const T& value) const;
+
+        typedef T* Iterator;
+
+        constexpr Iterator begin() { return data; }
+        constexpr Iterator end() { return data + N; }
+        constexpr const T* begin() const { return data; }
+        constexpr const T* end() const { return data + N; }
+        constexpr std::reverse_iterator<Iterator> rbegin() { return std::reverse_iterator<Iterator>{end()}; }
+        constexpr std::reverse_iterator<Iterator> rend() { return std::reverse_iterator<Iterator>{begin()}; } // data - 1 would point outside the array
+        constexpr const T* find(const T& value) const;
+
+        template <typename U, size_t M>
+        friend std::ostream& operator<<(std::ostream& out, const FixedArray<U, M>& arr);
+        template <typename U, size_t M>
+        friend std::istream& operator>>(std::istream& in, FixedArray<U, M>& arr);
+};
+
+template <typename T, size_t N>
+constexpr FixedArray<T, N>::FixedArray(std::initializer_list<T> values) : data{} {
+    if (values.size() > N) throw std::out_of_range("Too many elements");
+
+    size_t i = 0;
+    for (const T& value : values) data[i++] = value;
+}
+
+template <typename T, size_t N>
+constexpr T& FixedArray<T, N>::at(size_t index) {
+    if (index >= N) {
+        throw std::out_of_range("Invalid index");
+    }
+    return data[index];
+}
+
+template <typename T, size_t N>
+constexpr const T& FixedArray<T, N>::at(size_t index) const {
+    if (index >= N) {
+        throw std::out_of_range("Invalid index");
+    }
+    return data[index];
+}
+
+template <typename T, size_t N>
+constexpr void FixedArray<T, N>::fill(const T& value) {
+    for (size_t i = 0; i < N; ++i) data[i] = value;
+}
+
+template <typename T, size_t N>
+constexpr void FixedArray<T, N>::sort() {
+#if defined(__GNUC__) || defined(__clang__)
+    if (!__builtin_is_constant_evaluated()) { // at runtime, use the fast non-constexpr sorts
+        sortRange(data, data + N);
+        return;
+    }
+#endif
+    constexprSort(data, N);
+}
+
+template <typename T, size_t N>
+constexpr void FixedArray<T, N>::swap(size_t a, size_t b) {
+    constexprSwap(data[a], data[b]);
+}
+
+template <typename T, size_t N>
+constexpr const T* FixedArray<T, N>::find(const T& value) const {
+    for (size_t i = 0; i < N; ++i)
+        if (data[i] == value) return data + i;
+    return data + N;
+}
+
+template <typename T, size_t N>
+constexpr bool FixedArray<T, N>::contains(const T& value) const {
+    return find(value) != end();
+}
+
+template <typename T, size_t N>
+std::ostream& operator<<(std::ostream& out, const FixedArray<T, N>& arr) {
+    out << '{';
+    for (size_t i = 0; i < N; ++i) {
+        out << arr[i];
+        if (i != N - 1) out << ", ";
+    }
+    out << '}' << std::endl;
+    return out;
+}
+
+template <typename T, size_t N>
+std::istream& operator>>(std::istream& in, FixedArray<T, N>& arr) {
+    for (size_t i = 0; i < N; ++i) {
+        in >> arr.data[i];
+    }
+    return in;
+}
+
+// A table built entirely at compile time: the bit count of every byte
+constexpr FixedArray<uint8_t, 256> makePopcountTable() {
+    FixedArray<uint8_t, 256> table;
+    for (size_t i = 1; i < 256; ++i) table[i] = (uint8_t) (table[i / 2] + (i & 1));
+    return table;
+}
+
+constexpr FixedArray<int, 8> makeSortedPrimes() {
+    FixedArray<int, 8> primes{19, 2, 17, 5, 13, 3, 11, 7};
+    primes.sort();
+    return primes;
+}
+
+void testFixedArrayClass() {
+    constexpr auto popcount = makePopcountTable();
+    static_assert(popcount[255] == 8 && popcount[0x55] == 4, "popcount table is built at compile time");
+
+    constexpr auto primes = makeSortedPrimes();
+    static_assert(primes.front() == 2 && primes.back() == 19, "sorted at compile time");
+    static_assert(primes.contains(13) && !primes.contains(4), "searched at compile time");
+    static_assert(primes.span().last(3).front() == 13, "sliced at compile time");
+    std::cout << primes;
+    LOG("Popcount of 0xF0: " << (int) popcount[0xF0])
+
+    FixedArray<int, 5> arr2; // no heap: the elements are part of arr2
+    for (size_t i = 0; i < arr2.size(); ++i) {
+        arr2.at(i) = arr2.size() - i;
+    }
+
+    std::cout << arr2;
+    arr2.sort();
+    std::cout << arr2;
+    arr2.swap(0, 3);
+    std::cout << arr2;
+
+    FixedArray<std::string, 3> names{"Pat", "Sam"};
+    names.back() = "Kim";
+    FixedArray<std::string, 3> copy = names;
+    copy.sort();
+    std::cout << copy;
+    LOG("Found Sam at: " << names.find("Sam") - names.begin())
+
+    FixedArray<char, 64> scratch; // a per-packet buffer on the stack
+    scratch.fill('-');
+    LOG("Scratch: " << std::string(scratch.begin(), scratch.begin() + 8))
+
+    for (auto it = arr2.rbegin(); it != arr2.rend(); ++it) {
+        LOG(*it)
+    }
+
+    try {
+        arr2.at(5);
+    } catch (const std::out_of_range& e) {
+        LOG("Caught: " << e.what())
+    }
+}
+
+int main() {
+    testFixedArrayClass();
+}
@@ -0,0 +1,48 @@
+// C++ Data Structures
+
+#ifndef GROWTH_POLICY_H
+#define GROWTH_POLICY_H
+
+#include <algorithm>
+#include <cstddef>
+
+// A growth policy decides the next capacity of a contiguous buffer once [required] elements
+// no longer fit in [capacity]. The result is always >= required.
+
+struct DoublingGrowth {
+    static size_t grow(size_t capacity, size_t required, size_t) {
+        return std::max(required, capacity * 2);
+    }
+};
+
+// Less over-allocation than doubling, and freed blocks can eventually be reused by the buffer
+struct OneAndHalfGrowth {
+    static size_t grow(size_t capacity, size_t required, size_t) {
+        return std::max(required, capacity + capacity / 2);
+    }
+};
+
+// Linear growth: caps over-allocation at [Step] elements for memory-sensitive jobs
+template<size_t Step>
+struct FixedStepGrowth {
+    static_assert(Step > 0, "FixedStepGrowth needs a non-zero step");
+
+    static size_t grow(size_t capacity, size_t required, size_t) {
+        return std::max(required, capacity + Step);
+    }
+};
+
+// Rounds [Base]'s choice up to whole pages once the buffer is at least a page,
+// so huge buffers line up with what realloc/mremap hand out anyway
+template<typename Base = DoublingGrowth, size_t PageSize = 4096>
+struct PageRoundedGrowth {
+    static size_t grow(size_t capacity, size_t required, size_t elemSize) {
+        size_t bytes = Base::grow(capacity, required, elemSize) * elemSize;
+        if (bytes < PageSize) return bytes / elemSize;
+
+        bytes = (bytes + PageSize - 1) / PageSize * PageSize;
+        return bytes / elemSize;
+    }
+};
+
+#endif
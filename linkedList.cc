@@ -8,6 +8,13 @@
 #endif
 
 #include <iostream>
+#include <memory_resource>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "nodeAllocation.h"
+#include "nodePool.h"
 
 template<typename T>
 class LinkedList {
@@ -19,13 +26,17 @@ class LinkedList {
     Node* pHead;
     Node* pTail;
     size_t size;
+    std::pmr::memory_resource* resource;
+    NodePool nodePool; // every node comes from here; [resource] only supplies its slabs
 
     public:
         LinkedList();
+        explicit LinkedList(std::pmr::memory_resource* resource); // e.g. a per-request arena or a pool
         LinkedList(const LinkedList& other);
         LinkedList(LinkedList&& other);
         LinkedList& operator=(const LinkedList& other);
         LinkedList& operator=(LinkedList&& other);
+        std::pmr::memory_resource* getResource() const;
         
         constexpr size_t length() const noexcept;
         T& head();
@@ -68,23 +79,27 @@ class LinkedList {
 };
 
 template<typename T>
-LinkedList<T>::LinkedList() : pHead{nullptr}, pTail{nullptr}, size{0} {}
+LinkedList<T>::LinkedList() : LinkedList{std::pmr::get_default_resource()} {}
+
+template<typename T>
+LinkedList<T>::LinkedList(std::pmr::memory_resource* resource) : pHead{nullptr}, pTail{nullptr}, size{0}, resource{resource}, nodePool{sizeof(Node), alignof(Node), resource} {}
 
 template<typename T>
-LinkedList<T>::LinkedList(const LinkedList& other) : pHead{nullptr}, pTail{nullptr}, size{0} {
+LinkedList<T>::LinkedList(const LinkedList& other) : pHead{nullptr}, pTail{nullptr}, size{0}, resource{std::pmr::get_default_resource()},
+    nodePool{sizeof(Node), alignof(Node), resource} {
     Node* otherTraverser = other.pHead;
     Node* thisTraverser = nullptr;
     Node* thisNextTraverser = nullptr;
 
     if (otherTraverser) {
-        pHead = new Node{otherTraverser->data, nullptr};
+        pHead = createNode<Node>(&nodePool, otherTraverser->data, nullptr);
         thisTraverser = pHead;
     }
 
     while (otherTraverser) {
         ++size;
         otherTraverser = otherTraverser->next;
-        thisNextTraverser = otherTraverser? new Node{otherTraverser->data, nullptr} : otherTraverser;
+        thisNextTraverser = otherTraverser? createNode<Node>(&nodePool, otherTraverser->data, nullptr) : otherTraverser;
         thisTraverser->next = thisNextTraverser;
         if (thisNextTraverser) thisTraverser = thisTraverser->next;
     }
@@ -93,7 +108,7 @@ LinkedList<T>::LinkedList(const LinkedList& other) : pHead{nullptr}, pTail{nullp
 }
 
 template<typename T>
-LinkedList<T>::LinkedList(LinkedList&& other) : pHead{other.pHead}, pTail{other.pTail}, size{other.size} {
+LinkedList<T>::LinkedList(LinkedList&& other) : pHead{other.pHead}, pTail{other.pTail}, size{other.size}, resource{other.resource}, nodePool{std::move(other.nodePool)} {
     other.pHead = nullptr;
     other.pTail = nullptr;
     other.size = 0;
@@ -109,14 +124,14 @@ LinkedList<T>& LinkedList<T>::operator=(const LinkedList& other) {
     Node* thisNextTraverser = nullptr;
 
     if (otherTraverser) {
-        pHead = new Node{otherTraverser->data, nullptr};
+        pHead = createNode<Node>(&nodePool, otherTraverser->data, nullptr);
         thisTraverser = pHead;
     }
 
     while (otherTraverser) {
         ++size;
         otherTraverser = otherTraverser->next;
-        thisNextTraverser = otherTraverser? new Node{otherTraverser->data, nullptr} : otherTraverser;
+        thisNextTraverser = otherTraverser? createNode<Node>(&nodePool, otherTraverser->data, nullptr) : otherTraverser;
         thisTraverser->next = thisNextTraverser;
         if (thisNextTraverser) thisTraverser = thisTraverser->next;
     }
@@ -131,10 +146,15 @@ LinkedList<T>& LinkedList<T>::operator=(LinkedList&& other) {
     std::swap(pHead, other.pHead);
     std::swap(pTail, other.pTail);
     std::swap(size, other.size);
+    std::swap(resource, other.resource);
+    nodePool.swap(other.nodePool); // the nodes must go back to the pool they came from
 
     return *this;
 }
 
+template<typename T>
+std::pmr::memory_resource* LinkedList<T>::getResource() const { return resource; }
+
 template<typename T>
 constexpr size_t LinkedList<T>::length() const noexcept { return size; }
 
@@ -164,21 +184,21 @@ const T& LinkedList<T>::tail() const {
 
 template<typename T>
 void LinkedList<T>::add_to_front(const T& elem) {
-    Node* newNode = new Node{elem, pHead};
+    Node* newNode = createNode<Node>(&nodePool, elem, pHead);
     pHead = newNode;
     ++size;
 }
 
 template<typename T>
 void LinkedList<T>::add_to_front(T&& elem) {
-    Node* newNode = new Node{std::move(elem), pHead};
+    Node* newNode = createNode<Node>(&nodePool, std::move(elem), pHead);
     pHead = newNode;
     ++size;
 }
 
 template<typename T>
 void LinkedList<T>::push_back(const T& elem) {
-    Node* newNode = new Node{elem, nullptr};
+    Node* newNode = createNode<Node>(&nodePool, elem, nullptr);
 
     if (size == 0) {
         pHead = newNode;
@@ -193,7 +213,7 @@ void LinkedList<T>::push_back(const T& elem) {
 
 template<typename T>
 void LinkedList<T>::push_back(T&& elem) {
-    Node* newNode = new Node{std::move(elem), nullptr};
+    Node* newNode = createNode<Node>(&nodePool, std::move(elem), nullptr);
 
     if (size == 0) {
         pHead = newNode;
@@ -219,7 +239,7 @@ void LinkedList<T>::insert(const T& elem, size_t index) {
         ++i;
     }
 
-    Node* newNode = new Node{elem, traverser->next};
+    Node* newNode = createNode<Node>(&nodePool, elem, traverser->next);
     traverser->next = newNode;
 
     ++size;
@@ -238,7 +258,7 @@ void LinkedList<T>::insert(T&& elem, size_t index) {
         ++i;
     }
 
-    Node* newNode = new Node{std::move(elem), traverser->next};
+    Node* newNode = createNode<Node>(&nodePool, std::move(elem), traverser->next);
     traverser->next = newNode;
 
     ++size;
@@ -266,7 +286,7 @@ void LinkedList<T>::erase(int index) {
     }
 
     --size;
-    delete toBeDeleted;
+    destroyNode(&nodePool, toBeDeleted);
 }
 
 template<typename T>
@@ -393,14 +413,11 @@ void LinkedList<T>::reverse() {
 
 template<typename T>
 void LinkedList<T>::clear() {
-    Node* traverser = pHead;
-    Node* tempNode = nullptr;
-
-    while(traverser) {
-        tempNode = traverser->next;
-        delete traverser;
-        traverser = tempNode;
+    if constexpr (!std::is_trivially_destructible<T>::value) {
+        for (Node* traverser = pHead; traverser; traverser = traverser->next)
+            traverser->data.~T();
     }
+    nodePool.release(); // hands back whole slabs instead of freeing node by node
 
     size = 0;
     pHead = nullptr;
@@ -409,14 +426,11 @@ void LinkedList<T>::clear() {
 
 template<typename T>
 LinkedList<T>::~LinkedList() {
-    Node* traverser = pHead;
-    Node* tempNode = nullptr;
-
-    while(traverser) {
-        tempNode = traverser->next;
-        delete traverser;
-        traverser = tempNode;
+    if constexpr (!std::is_trivially_destructible<T>::value) {
+        for (Node* traverser = pHead; traverser; traverser = traverser->next)
+            traverser->data.~T();
     }
+    // nodePool hands back whole slabs when it's destroyed
 }
 
 template<typename T>
@@ -483,6 +497,12 @@ void testLinkedList() {
     std::cout << friends << std::endl;
     friends.reverse();
     std::cout << friends << std::endl;
+
+    std::pmr::monotonic_buffer_resource requestArena;
+    LinkedList<std::string> arenaFriends{&requestArena};
+    arenaFriends.push_back("Maya");
+    arenaFriends.add_to_front("Omar");
+    std::cout << arenaFriends << std::endl;
 }
 
 int main() {
@@ -8,6 +8,13 @@
 #endif
 
 #include <iostream>
+#include <memory_resource>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "nodeAllocation.h"
+#include "nodePool.h"
 
 template<typename K, typename V>
 class Map {
@@ -20,6 +27,8 @@ class Map {
         MapNode* right;
     };
 
+    std::pmr::memory_resource* resource; // declared first: deepCopy needs these while root is initialized
+    NodePool nodePool; // every node comes from here; [resource] only supplies its slabs
     MapNode* root;
     size_t nodeCount;
         // modify these three to updata the parents children and the parents
@@ -32,15 +41,18 @@ class Map {
         MapNode* mapRemove(const K& elem);
         int height(MapNode* node) const;
         void clear(MapNode* node);
+        void releaseNodes();
         MapNode* deepCopy(MapNode* other, MapNode* parent);
         void setHeight(MapNode* node);
         MapNode* get(const K& key);
     public:
         Map();
+        explicit Map(std::pmr::memory_resource* resource); // e.g. a per-request arena or a pool
         Map(const Map& other);
         Map(Map&& other);
         Map& operator=(const Map& other);
         Map& operator=(Map&& other);
+        std::pmr::memory_resource* getResource() const;
         void insert(const K& key, const V& value);
         V& operator[](const K& key);
         const V& operator[](const K& key) const;
@@ -123,7 +135,7 @@ typename Map<K, V>::MapNode* Map<K, V>::restructure(MapNode* x, MapNode* y, MapN
 template<typename K, typename V>
 typename Map<K, V>::MapNode* Map<K, V>::mapInsert(const K& key, const V& value) {
     if (!root) {
-        root = new MapNode{key, value, 0, nullptr, nullptr, nullptr};
+        root = createNode<MapNode>(&nodePool, key, value, 0, nullptr, nullptr, nullptr);
         ++nodeCount;
         return root;
     }
@@ -133,7 +145,7 @@ typename Map<K, V>::MapNode* Map<K, V>::mapInsert(const K& key, const V& value)
             return node;
         } else if (node->key < key) {
             if (!node->right) {
-                node->right = new MapNode{key, value, 0, node, nullptr, nullptr};
+                node->right = createNode<MapNode>(&nodePool, key, value, 0, node, nullptr, nullptr);
                 ++nodeCount;
                 return node->right;
             } else {
@@ -141,7 +153,7 @@ typename Map<K, V>::MapNode* Map<K, V>::mapInsert(const K& key, const V& value)
             }
         } else { // key < node->data
             if (!node->left) {
-                node->left = new MapNode{key, value, 0, node, nullptr, nullptr};
+                node->left = createNode<MapNode>(&nodePool, key, value, 0, node, nullptr, nullptr);
                 ++nodeCount;
             } else {
                 node = node->left;
@@ -252,7 +264,7 @@ typename Map<K, V>::MapNode* Map<K, V>::mapRemove(const K& elem) {
         }
     }
 
-    delete(toBeDeleted);
+    destroyNode(&nodePool, toBeDeleted);
     --nodeCount;
 
     return node;
@@ -269,23 +281,30 @@ void Map<K, V>::clear(MapNode* node) {
     if (node) {
         clear(node->left);
         clear(node->right);
-        delete node;
+        node->~MapNode(); // the memory goes back with the slabs in releaseNodes
     }
 }
 
+template<typename K, typename V>
+void Map<K, V>::releaseNodes() {
+    if constexpr (!std::is_trivially_destructible<MapNode>::value) clear(root); // only runs the destructors
+    nodePool.release(); // hands back whole slabs instead of freeing node by node
+    root = nullptr;
+}
+
 template<typename K, typename V>
 typename Map<K, V>::MapNode* Map<K, V>::deepCopy(MapNode* other, MapNode* parent) {
     if (!other) {
         return nullptr;
     }
-    MapNode* node = new MapNode{
+    MapNode* node = createNode<MapNode>(&nodePool,
         other->key,
         other->value,
         other->height,
         parent,
         nullptr,
         nullptr
-    };
+    );
 
     if (!root) root = node;
 
@@ -322,20 +341,24 @@ typename Map<K, V>::MapNode* Map<K, V>::get(const K& key) {
 }
 
 template<typename K, typename V>
-Map<K, V>::Map() : root{nullptr}, nodeCount{0} {}
+Map<K, V>::Map() : Map{std::pmr::get_default_resource()} {}
 
 template<typename K, typename V>
-Map<K, V>::Map(const Map& other) : root{deepCopy(other.root, nullptr)}, nodeCount{other.count()} {}
+Map<K, V>::Map(std::pmr::memory_resource* resource) : resource{resource}, nodePool{sizeof(MapNode), alignof(MapNode), resource}, root{nullptr}, nodeCount{0} {}
 
 template<typename K, typename V>
-Map<K, V>::Map(Map&& other) : root{other.root}, nodeCount{other.count()} {
+Map<K, V>::Map(const Map& other) : resource{std::pmr::get_default_resource()},
+    nodePool{sizeof(MapNode), alignof(MapNode), resource}, root{deepCopy(other.root, nullptr)}, nodeCount{other.count()} {}
+
+template<typename K, typename V>
+Map<K, V>::Map(Map&& other) : resource{other.resource}, nodePool{std::move(other.nodePool)}, root{other.root}, nodeCount{other.count()} {
     other.root = nullptr;
 }
 
 template<typename K, typename V>
 Map<K, V>& Map<K, V>::operator=(const Map& other) {
     nodeCount = other.nodeCount;
-    clear(root);
+    releaseNodes();
     deepCopy(other.root, nullptr);
 
     return *this;
@@ -345,10 +368,15 @@ template<typename K, typename V>
 Map<K, V>& Map<K, V>::operator=(Map&& other) {
     std::swap(root, other.root);
     std::swap(nodeCount, other.nodeCount);
+    std::swap(resource, other.resource);
+    nodePool.swap(other.nodePool); // the nodes must go back to the pool they came from
 
     return *this;
 }
 
+template<typename K, typename V>
+std::pmr::memory_resource* Map<K, V>::getResource() const { return resource; }
+
 template<typename K, typename V>
 void Map<K, V>::insert(const K& key, const V& value) {
     MapNode* addedNode = mapInsert(key, value);
@@ -618,7 +646,7 @@ int Map<K, V>::height() const {
 
 template<typename K, typename V>
 Map<K, V>::~Map() {
-    clear(root);
+    releaseNodes();
 }
 
 
@@ -644,6 +672,12 @@ void testMap() {
     std::cout << raptors << std::endl;
     LOG(raptors.size())
     LOG(raptors.empty())
+
+    std::pmr::unsynchronized_pool_resource nodePool;
+    Map<int, std::string> pooledRoster{&nodePool};
+    pooledRoster.insert(2, "Kawhi");
+    pooledRoster.insert(24, "Kobe");
+    std::cout << pooledRoster << std::endl;
 }
 
 int main() {
@@ -0,0 +1,454 @@
+// C++ Data Structures
+
+#define DEBUG_MODE 1
+#if DEBUG_MODE
+#define LOG(x) std::cout << x << std::endl;
+#else
+#define LOG(x)
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "growthPolicy.h"
+#include "radixSort.h"
+
+/* MmapVector
+- A Vector whose buffer is a file mapped into memory, for datasets larger than RAM or ones that
+  should survive a restart: reopening the file maps yesterday's data instead of re-parsing it
+- The file starts with a small header (magic, element size, size), followed by the elements
+- Growing extends the file with ftruncate and the mapping with mremap, which moves page tables
+  rather than copying data
+- Only trivially copyable T: the bytes in the file are the objects
+*/
+
+enum class MmapAccess { Normal, Sequential, Random, WillNeed, DontNeed };
+
+template<typename T, typename Growth = DoublingGrowth>
+class MmapVector {
+    static_assert(std::is_trivially_copyable<T>::value, "MmapVector stores raw bytes, so T must be trivially copyable");
+
+    struct Header {
+        uint64_t magic;
+        uint64_t elemSize;
+        uint64_t size; // lives in the mapping, so every push_back is persisted with the data
+    };
+
+    static constexpr uint64_t fileMagic = 0x524f54434556504dULL; // "MPVECTOR"
+    static constexpr size_t dataOffset = (sizeof(Header) + alignof(T) + 63) / 64 * 64;
+
+    std::string path;
+    int fd;
+    char* mapping;
+    size_t mappedBytes;
+    size_t vecCapacity;
+
+        Header* header() const { return (Header*) mapping; }
+        T* data() const { return (T*) (mapping + dataOffset); }
+        static size_t fileBytes(size_t capacity) { return dataOffset + capacity * sizeof(T); }
+        static void check(bool ok, const char* call);
+        [[noreturn]] void closeAndThrow(const char* call); // for the constructor, before the mapping exists
+        void remap(size_t newCap);
+        void grow(size_t required);
+        void close();
+    public:
+        explicit MmapVector(const std::string& path); // opens the file, or creates it if missing
+        MmapVector(const MmapVector& other) = delete;
+        MmapVector(MmapVector&& other);
+        MmapVector& operator=(const MmapVector& other) = delete;
+        MmapVector& operator=(MmapVector&& other);
+        size_t size() const;
+        size_t capacity() const;
+        const std::string& getPath() const;
+        void reserve(size_t newCap);
+        void shrink_to_fit();
+        void resize(size_t newSize);
+        void resize(size_t newSize, const T& value);
+        T* getData();
+        const T* getData() const;
+        T& operator[](size_t index);
+        const T& operator[](size_t index) const;
+        void push_back(const T& elem);
+        void pop_back();
+        template<typename... args>
+        void emplace_back(args&&... myArgs);
+        void insert(const T& elem, size_t n);
+        void erase(size_t n);
+        void clear();
+        T& front();
+        const T& front() const;
+        T& back();
+        const T& back() const;
+        bool isEmpty() const;
+        void sort(); // radix sort for integer and float elements
+        void swap(int a, int b);
+        void flush(); // blocks until dirty pages are on disk (msync MS_SYNC)
+        void flushAsync(); // schedules write-back and returns (msync MS_ASYNC)
+        void advise(MmapAccess access); // madvise hint for the page cache
+        typedef T* Iterator;
+        Iterator begin() const { return Iterator{data()}; }
+        Iterator end() const { return Iterator{data() + size()}; }
+        Iterator rbegin() const { return Iterator{data() + size() - 1}; }
+        Iterator rend() const { return Iterator{data() - 1}; }
+        template <typename U, typename G>
+        friend std::ostream& operator<<(std::ostream& out, const MmapVector<U, G>& v);
+        ~MmapVector();
+};
+
+template<typename T, typename Growth>
+void MmapVector<T, Growth>::check(bool ok, const char* call) {
+    if (!ok) throw std::system_error(errno, std::generic_category(), call);
+}
+
+template<typename T, typename Growth>
+void MmapVector<T, Growth>::closeAndThrow(const char* call) {
+    int error = errno; // close() may overwrite it
+    ::close(fd);
+    fd = -1;
+    throw std::system_error(error, std::generic_category(), call);
+}
+
+template<typename T, typename Growth>
+void MmapVector<T, Growth>::remap(size_t newCap) {
+    size_t newBytes = fileBytes(newCap);
+    if (newBytes > mappedBytes) check(ftruncate(fd, (off_t) newBytes) == 0, "ftruncate");
+
+#ifdef __linux__
+    void* resized = mremap(mapping, mappedBytes, newBytes, MREMAP_MAYMOVE);
+    check(resized != MAP_FAILED, "mremap");
+#else
+    check(munmap(mapping, mappedBytes) == 0, "munmap");
+    void* resized = mmap(nullptr, newBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    check(resized != MAP_FAILED, "mmap");
+#endif
+
+    if (newBytes < mappedBytes) check(ftruncate(fd, (off_t) newBytes) == 0, "ftruncate");
+    mapping = (char*) resized;
+    mappedBytes = newBytes;
+    vecCapacity = newCap;
+}
+
+template<typename T, typename Growth>
+void MmapVector<T, Growth>::grow(size_t required) {
+    remap(Growth::grow(vecCapacity, required, sizeof(T)));
+}
+
+template<typename T, typename Growth>
+void MmapVector<T, Growth>::close() {
+    if (!mapping) return;
+
+    size_t used = fileBytes(size());
+    munmap(mapping, mappedBytes); // the kernel writes back any dirty pages
+    if (ftruncate(fd, (off_t) used) != 0) {} // drop the unused capacity; a failure just leaves slack
+    ::close(fd);
+
+    mapping = nullptr;
+    fd = -1;
+}
+
+template<typename T, typename Growth>
+MmapVector<T, Growth>::MmapVector(const std::string& path) : path{path}, fd{-1}, mapping{nullptr}, mappedBytes{0}, vecCapacity{0} {
+    fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    check(fd >= 0, "open");
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        closeAndThrow("fstat");
+    }
+
+    size_t bytes = (size_t) info.st_size;
+    bool isNew = bytes == 0;
+    if (isNew) bytes = dataOffset;
+
+    if (!isNew && (bytes < dataOffset || (bytes - dataOffset) % sizeof(T) != 0)) {
+        ::close(fd);
+        throw std::invalid_argument("Not an MmapVector file");
+    }
+    if (isNew && ftruncate(fd, (off_t) bytes) != 0) {
+        closeAndThrow("ftruncate");
+    }
+
+    void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) {
+        closeAndThrow("mmap");
+    }
+    mapping = (char*) memory;
+    mappedBytes = bytes;
+    vecCapacity = (bytes - dataOffset) / sizeof(T);
+
+    if (isNew) {
+        header()->magic = fileMagic;
+        header()->elemSize = sizeof(T);
+        header()->size = 0;
+    } else if (header()->magic != fileMagic || header()->elemSize != sizeof(T) || header()->size > vecCapacity) {
+        close();
+        throw std::invalid_argument("Not an MmapVector file of this element type");
+    }
+}
+
+template<typename T, typename Growth>
+MmapVector<T, Growth>::MmapVector(MmapVector&& other) :
+    path{std::move(other.path)}, fd{other.fd}, mapping{other.mapping}, mappedBytes{other.mappedBytes}, vecCapacity{other.vecCapacity} {
+        other.fd = -1;
+        other.mapping = nullptr;
+        other.mappedBytes = 0;
+        other.vecCapacity = 0;
+    }
+
+template<typename T, typename Growth>
+MmapVector<T, Growth>& MmapVector<T, Growth>::operator=(MmapVector&& other) {
+    if (&other == this) return *this;
+
+    close();
+    std::swap(path, other.path);
+    std::swap(fd, other.fd);
+    std::swap(mapping, other.mapping);
+    std::swap(mappedBytes, other.mappedBytes);
+    std::swap(vecCapacity, other.vecCapacity);
+
+    return *this;
+}
+
+template<typename T, typename Growth>
+size_t MmapVector<T, Growth>::size() const { return mapping ? header()->size : 0; }
+
+template<typename T, typename Growth>
+size_t MmapVector<T, Growth>::capacity() const { return vecCapacity; }
+
+template<typename T, typename Growth>
+const std::string& MmapVector<T, Growth>::getPath() const { return path; }
+
+template<typename T, typename Growth>
+void MmapVector<T, Growth>::reserve(size_t newCap) {
+    if (newCap > vecCapacity) remap(newCap);
+}
+
+template<typename T, typename Growth>
+void MmapVector<T, Growth>::shrink_to_fit() {
+    if (vecCapacity > size()) remap(size());
+}
+
+template<typename T, typename Growth>
+void MmapVector<T, Growth>::resize(size_t newSize) {
+    resize(newSize, T{});
+}
+
+template<typename T, typename Growth>
+void MmapVector<T, Growth>::resize(size_t newSize, const T& value) {
+    if (newSize > vecCapacity) grow(newSize);
+    if (newSize > size()) std::fill(data() + size(), data() + newSize, value);
+    header()->size = newSize;
+}
+
+template<typename T, typename Growth>
+T* MmapVector<T, Growth>::getData() { return data(); }
+
+template<typename T, typename Growth>
+const T* MmapVector<T, Growth>::getData() const { return data(); }
+
+template<typename T, typename Growth>
+T& MmapVector<T, Growth>::operator[](size_t index) {
+    return data()[index];
+}
+
+template<typename T, typename Growth>
+const T& MmapVector<T, Growth>::operator[](size_t index) const {
+    return data()[index];
+}
+
+template<typename T, typename Growth>
+void MmapVector<T, Growth>::push_back(const T& elem) {
+    if (size() == vecCapacity) {
+        T copy = elem; // [elem] may live in the mapping that's about to move
+        grow(size() + 1);
+        data()[header()->size++] = copy;
+        return;
+    }
+    data()[header()->size++] = elem;
+}
+
+template<typename T, typename Growth>
+void MmapVector<T, Growth>::pop_back() {
+    if (size() == 0) return;
+    --header()->size;
+}
+
+template<typename T, typename Growth>
+template<typename... args>
+void MmapVector<T, Growth>::emplace_back(args&&... myArgs) {
+    push_back(T{std::forward<args>(myArgs)...});
+}
+
+template<typename T, typename Growth>
+void MmapVector<T, Growth>::insert(const T& elem, size_t n) {
+    if (n > size()) {
+        throw std::out_of_range("Invalid index");
+    }
+    T copy = elem;
+    if (size() == vecCapacity) grow(size() + 1);
+
+    std::memmove(data() + n + 1, data() + n, sizeof(T) * (size() - n));
+    data()[n] = copy;
+    ++header()->size;
+}
+
+template<typename T, typename Growth>
+void MmapVector<T, Growth>::erase(size_t n) {
+    if (n >= size()) {
+        throw std::out_of_range("Invalid index");
+    }
+
+    std::memmove(data() + n, data() + n + 1, sizeof(T) * (size() - n - 1));
+    --header()->size;
+}
+
+template<typename T, typename Growth>
+void MmapVector<T, Growth>::clear() {
+    header()->size = 0;
+}
+
+template<typename T, typename Growth>
+T& MmapVector<T, Growth>::front() {
+    if (size() == 0) throw std::out_of_range("Empty array");
+    return data()[0];
+}
+
+template<typename T, typename Growth>
+const T& MmapVector<T, Growth>::front() const {
+    if (size() == 0) throw std::out_of_range("Empty array");
+    return data()[0];
+}
+
+template<typename T, typename Growth>
+T& MmapVector<T, Growth>::back() {
+    if (size() == 0) throw std::out_of_range("Empty array");
+    return data()[size() - 1];
+}
+
+template<typename T, typename Growth>
+const T& MmapVector<T, Growth>::back() const {
+    if (size() == 0) throw std::out_of_range("Empty array");
+    return data()[size() - 1];
+}
+
+template<typename T, typename Growth>
+bool MmapVector<T, Growth>::isEmpty() const {
+    return size() == 0;
+}
+
+template<typename T, typename Growth>
+void MmapVector<T, Growth>::sort() {
+    sortRange(begin(), end());
+}
+
+template<typename T, typename Growth>
+void MmapVector<T, Growth>::swap(int a, int b) {
+    std::swap(data()[a], data()[b]);
+}
+
+template<typename T, typename Growth>
+void MmapVector<T, Growth>::flush() {
+    check(msync(mapping, fileBytes(size()), MS_SYNC) == 0, "msync");
+}
+
+template<typename T, typename Growth>
+void MmapVector<T, Growth>::flushAsync() {
+    check(msync(mapping, fileBytes(size()), MS_ASYNC) == 0, "msync");
+}
+
+template<typename T, typename Growth>
+void MmapVector<T, Growth>::advise(MmapAccess access) {
+    int advice = MADV_NORMAL;
+    switch (access) {
+        case MmapAccess::Normal: advice = MADV_NORMAL; break;
+        case MmapAccess::Sequential: advice = MADV_SEQUENTIAL; break;
+        case MmapAccess::Random: advice = MADV_RANDOM; break;
+        case MmapAccess::WillNeed: advice = MADV_WILLNEED; break;
+        case MmapAccess::DontNeed: advice = MADV_DONTNEED; break;
+    }
+    check(madvise(mapping, mappedBytes, advice) == 0, "madvise");
+}
+
+template<typename T, typename Growth>
+std::ostream& operator<<(std::ostream& out, const MmapVector<T, Growth>& v) {
+    out << "{";
+    for (size_t i = 0; i < v.size(); ++i) {
+        out << v[i];
+        if (i != v.size() - 1) out << ", ";
+    }
+    out << "}" << std::endl;
+    return out;
+}
+
+template<typename T, typename Growth>
+MmapVector<T, Growth>::~MmapVector() {
+    close();
+}
+
+void testMmapVectorClass() {
+    std::string path = (std::filesystem::temp_directory_path() / "mmapVector.test.bin").string();
+    std::filesystem::remove(path);
+
+    {
+        MmapVector<int> readings{path};
+        for (int i = 0; i < 10; ++i) readings.push_back(10 - i);
+        std::cout << readings;
+        readings.sort();
+        readings.insert(42, 3);
+        readings.erase(0);
+        std::cout << readings;
+        readings.flush();
+        LOG("Size: " << readings.size() << ", capacity: " << readings.capacity())
+    } // closing trims the file to the elements actually in use
+
+    {
+        MmapVector<int> reopened{path}; // maps the previous run's data, no parsing
+        std::cout << reopened;
+        LOG("Front: " << reopened.front() << ", back: " << reopened.back())
+
+        reopened.advise(MmapAccess::Sequential);
+        for (int i = 0; i < 1000000; ++i) reopened.push_back(i % 1000); // grows with ftruncate + mremap
+        reopened.flushAsync();
+        LOG("Size after growth: " << reopened.size())
+
+        MmapVector<int> moved{std::move(reopened)};
+        moved.resize(5);
+        moved.shrink_to_fit();
+        std::cout << moved;
+        moved.clear();
+        moved.pop_back(); // like Vector, popping an empty vector does nothing
+        LOG("Size after popping empty: " << moved.size())
+    }
+
+    try {
+        MmapVector<double> wrongType{path};
+    } catch (const std::invalid_argument& e) {
+        LOG("Rejected: " << e.what())
+    }
+
+    try {
+        MmapVector<int> device{"/dev/null"}; // opens and looks empty, but can't be resized
+    } catch (const std::system_error& e) {
+        LOG("Failed: " << e.what()) // the ftruncate error, not whatever closing the file left in errno
+    }
+
+    std::filesystem::remove(path);
+}
+
+int main() {
+    testMmapVectorClass();
+}
@@ -0,0 +1,31 @@
+// C++ Data Structures
+
+#ifndef NODE_ALLOCATION_H
+#define NODE_ALLOCATION_H
+
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+// Node-based containers get their nodes from a std::pmr::memory_resource instead of new/delete,
+// so arenas (monotonic_buffer_resource), pools or NUMA-local resources can sit underneath them.
+
+template<typename Node, typename... Args>
+Node* createNode(std::pmr::memory_resource* resource, Args&&... args) {
+    void* memory = resource->allocate(sizeof(Node), alignof(Node));
+    try {
+        return new(memory) Node{std::forward<Args>(args)...};
+    } catch (...) {
+        resource->deallocate(memory, sizeof(Node), alignof(Node));
+        throw;
+    }
+}
+
+template<typename Node>
+void destroyNode(std::pmr::memory_resource* resource, Node* node) {
+    if (!node) return;
+    node->~Node();
+    resource->deallocate(node, sizeof(Node), alignof(Node));
+}
+
+#endif
@@ -0,0 +1,211 @@
+// C++ Data Structures
+
+#ifndef NODE_POOL_H
+#define NODE_POOL_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <utility>
+
+/* Node Pool
+- A memory_resource for fixed-size nodes, carved out of 64 KiB slabs taken from an upstream resource
+- Freed nodes go on an intrusive free list, so push/pop churn never reaches the upstream allocator
+- release() hands back whole slabs at once; containers call it instead of freeing node by node
+- Nodes too big or too aligned for a slab come straight from upstream, but the pool keeps them on a
+  list of its own so release() frees them too
+- Each thread keeps a small cache of spare default-heap slabs, so building a container right after
+  destroying one on the same thread doesn't touch the global allocator either
+*/
+
+class NodePool : public std::pmr::memory_resource {
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct Slab { // header at the start of every slab
+        Slab* next;
+        size_t bytes;
+    };
+
+    struct LargeBlock { // header just below every block allocated straight from upstream
+        LargeBlock* next;
+        LargeBlock* prev;
+        void* allocation; // what upstream returned, which the header may not start at
+        size_t bytes;
+        size_t alignment;
+    };
+
+    // Spare slabs from the default heap, kept per thread (bounded) so no locking is needed
+    class SlabCache {
+            static constexpr size_t maxSlabs = 64;
+            Slab* slabs = nullptr;
+            size_t slabCount = 0;
+        public:
+            Slab* take() {
+                if (!slabs) return nullptr;
+                Slab* slab = slabs;
+                slabs = slabs->next;
+                --slabCount;
+                return slab;
+            }
+
+            bool give(Slab* slab) {
+                if (slabCount == maxSlabs) return false;
+                slab->next = slabs;
+                slabs = slab;
+                ++slabCount;
+                return true;
+            }
+
+            ~SlabCache() {
+                threadCacheDestroyed() = true; // containers destroyed after this point skip the cache
+                while (Slab* slab = take())
+                    std::pmr::new_delete_resource()->deallocate(slab, slabSize, slabAlignment);
+            }
+    };
+
+    static constexpr size_t slabSize = 64 * 1024;
+    static constexpr size_t slabAlignment = alignof(std::max_align_t);
+
+    size_t blockSize;
+    size_t blockAlignment;
+    std::pmr::memory_resource* upstream;
+    Slab* slabs;
+    LargeBlock* largeBlocks;
+    FreeBlock* freeList;
+    char* bumpCurrent; // unused tail of the newest slab
+    char* bumpEnd;
+
+        static bool& threadCacheDestroyed() {
+            thread_local bool destroyed = false;
+            return destroyed;
+        }
+
+        static SlabCache* threadSlabCache() {
+            if (threadCacheDestroyed()) return nullptr;
+            thread_local SlabCache cache;
+            return &cache;
+        }
+
+        static size_t roundUp(size_t n, size_t alignment) { return (n + alignment - 1) / alignment * alignment; }
+
+        bool isCacheable() const { return upstream->is_equal(*std::pmr::new_delete_resource()); }
+
+        void addSlab() {
+            SlabCache* cache = isCacheable() ? threadSlabCache() : nullptr;
+            Slab* slab = cache ? cache->take() : nullptr;
+            if (!slab) slab = (Slab*) upstream->allocate(slabSize, slabAlignment);
+
+            slab->next = slabs;
+            slab->bytes = slabSize;
+            slabs = slab;
+
+            bumpCurrent = (char*) slab + roundUp(sizeof(Slab), blockAlignment);
+            bumpEnd = (char*) slab + slabSize;
+        }
+
+        void* allocateLarge(size_t bytes, size_t alignment) {
+            alignment = alignment < alignof(LargeBlock) ? alignof(LargeBlock) : alignment;
+            size_t offset = roundUp(sizeof(LargeBlock), alignment);
+            void* allocation = upstream->allocate(offset + bytes, alignment);
+
+            char* memory = (char*) allocation + offset;
+            LargeBlock* block = (LargeBlock*) memory - 1;
+            *block = LargeBlock{largeBlocks, nullptr, allocation, offset + bytes, alignment};
+            if (largeBlocks) largeBlocks->prev = block;
+            largeBlocks = block;
+            return memory;
+        }
+
+        void deallocateLarge(void* memory) {
+            LargeBlock* block = (LargeBlock*) memory - 1;
+            if (block->prev) block->prev->next = block->next;
+            else largeBlocks = block->next;
+            if (block->next) block->next->prev = block->prev;
+            upstream->deallocate(block->allocation, block->bytes, block->alignment);
+        }
+
+        // Oversized or over-aligned requests (and nodes too big to pack well into a slab) go straight upstream
+        bool isPooled(size_t bytes, size_t alignment) const {
+            return bytes <= blockSize && alignment <= blockAlignment &&
+                blockSize <= slabSize / 16 && blockAlignment <= slabAlignment;
+        }
+
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            if (!isPooled(bytes, alignment)) return allocateLarge(bytes, alignment);
+
+            if (freeList) {
+                FreeBlock* block = freeList;
+                freeList = freeList->next;
+                return block;
+            }
+
+            if ((size_t) (bumpEnd - bumpCurrent) < blockSize) addSlab();
+            void* block = bumpCurrent;
+            bumpCurrent += blockSize;
+            return block;
+        }
+
+        void do_deallocate(void* memory, size_t bytes, size_t alignment) override {
+            if (!isPooled(bytes, alignment)) return deallocateLarge(memory);
+
+            FreeBlock* block = (FreeBlock*) memory;
+            block->next = freeList;
+            freeList = block;
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    public:
+        NodePool(size_t nodeSize, size_t nodeAlignment, std::pmr::memory_resource* upstream = std::pmr::get_default_resource()) :
+            blockSize{0}, blockAlignment{nodeAlignment < alignof(FreeBlock) ? alignof(FreeBlock) : nodeAlignment},
+            upstream{upstream}, slabs{nullptr}, largeBlocks{nullptr}, freeList{nullptr}, bumpCurrent{nullptr}, bumpEnd{nullptr} {
+                blockSize = roundUp(nodeSize < sizeof(FreeBlock) ? sizeof(FreeBlock) : nodeSize, blockAlignment);
+            }
+
+        NodePool(const NodePool& other) = delete;
+        NodePool& operator=(const NodePool& other) = delete;
+
+        // Moving a container moves its nodes, so the slabs that hold them move too
+        NodePool(NodePool&& other) :
+            blockSize{other.blockSize}, blockAlignment{other.blockAlignment}, upstream{other.upstream},
+            slabs{other.slabs}, largeBlocks{other.largeBlocks}, freeList{other.freeList}, bumpCurrent{other.bumpCurrent}, bumpEnd{other.bumpEnd} {
+                other.slabs = nullptr;
+                other.largeBlocks = nullptr;
+                other.freeList = nullptr;
+                other.bumpCurrent = other.bumpEnd = nullptr;
+            }
+
+        void swap(NodePool& other) {
+            std::swap(blockSize, other.blockSize);
+            std::swap(blockAlignment, other.blockAlignment);
+            std::swap(upstream, other.upstream);
+            std::swap(slabs, other.slabs);
+            std::swap(largeBlocks, other.largeBlocks);
+            std::swap(freeList, other.freeList);
+            std::swap(bumpCurrent, other.bumpCurrent);
+            std::swap(bumpEnd, other.bumpEnd);
+        }
+
+        std::pmr::memory_resource* upstreamResource() const { return upstream; }
+
+        // Returns every slab and large block at once. Any nodes still in them must already be destroyed.
+        void release() {
+            SlabCache* cache = isCacheable() ? threadSlabCache() : nullptr;
+
+            while (slabs) {
+                Slab* slab = slabs;
+                slabs = slabs->next;
+                if (!cache || !cache->give(slab))
+                    upstream->deallocate(slab, slab->bytes, slabAlignment);
+            }
+
+            while (largeBlocks) deallocateLarge(largeBlocks + 1);
+
+            freeList = nullptr;
+            bumpCurrent = bumpEnd = nullptr;
+        }
+
+        ~NodePool() { release(); }
+};
+
+#endif
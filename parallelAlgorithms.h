@@ -0,0 +1,155 @@
+// C++ Data Structures
+
+#ifndef PARALLEL_ALGORITHMS_H
+#define PARALLEL_ALGORITHMS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+#include "span.h"
+#include "threadPool.h"
+
+/* Parallel Algorithms
+- parallelForEach, parallelTransform, parallelReduce, parallelTransformReduce and parallelScan
+  (prefix sums) over a Span, so they work on Array, Vector and FixedArray through span()
+- Work runs on a ThreadPool (the shared one by default) and the calling thread helps
+- Static scheduling gives each thread one equal chunk; Dynamic cuts the range into smaller chunks
+  that threads claim as they finish, for uneven per-element work
+- Chunk boundaries fall on cache-line boundaries of the written buffer, so no two threads write to
+  the same line, and per-chunk partial results sit in their own cache lines (no false sharing)
+- Ranges below parallelThreshold elements run on the calling thread alone
+- reduce must be associative, but needn't be commutative: partial results are combined in order
+*/
+
+enum class Schedule { Static, Dynamic };
+
+constexpr size_t parallelThreshold = 1 << 14;
+constexpr size_t cacheLineBytes = 64;
+constexpr size_t dynamicChunksPerThread = 8;
+
+template<typename R>
+struct alignas(cacheLineBytes) PaddedSlot {
+    R value;
+};
+
+// Chunk c covers [begin(c), end(c)); every boundary except 0 and n is cache-line aligned
+struct Partition {
+    size_t n;
+    size_t chunkSize;
+    size_t shift; // elements before the first cache-line boundary, counted back from chunkSize
+    size_t count;
+
+    size_t begin(size_t c) const { return c == 0 ? 0 : c * chunkSize - shift; }
+    size_t end(size_t c) const { return std::min(n, (c + 1) * chunkSize - shift); }
+};
+
+template<typename T>
+Partition partitionRange(const T* data, size_t n, Schedule schedule, const ThreadPool& pool) {
+    if (n < parallelThreshold) return Partition{n, std::max<size_t>(1, n), 0, 1};
+
+    size_t lineElements = cacheLineBytes % sizeof(T) == 0 ? cacheLineBytes / sizeof(T) : 1;
+    size_t chunks = (pool.size() + 1) * (schedule == Schedule::Dynamic ? dynamicChunksPerThread : 1);
+
+    size_t chunkSize = (n + chunks - 1) / chunks;
+    chunkSize = std::max<size_t>(1, (chunkSize + lineElements - 1) / lineElements * lineElements);
+
+    size_t misalignment = (size_t) ((uintptr_t) data % cacheLineBytes) / sizeof(T);
+    size_t shift = lineElements > 1 ? misalignment % lineElements : 0; // chunk 0 is shorter by this much
+    return Partition{n, chunkSize, shift, (n + shift + chunkSize - 1) / chunkSize};
+}
+
+// f(element) for every element
+template<typename T, typename F>
+void parallelForEach(Span<T> range, F f, Schedule schedule = Schedule::Static, ThreadPool& pool = ThreadPool::shared()) {
+    Partition part = partitionRange(range.getData(), range.size(), schedule, pool);
+    pool.run(part.count, [&](size_t c) {
+        for (size_t i = part.begin(c); i < part.end(c); ++i) f(range[i]);
+    });
+}
+
+// out[i] = f(in[i]); [in] and [out] may be the same span
+template<typename T, typename U, typename F>
+void parallelTransform(Span<T> in, Span<U> out, F f, Schedule schedule = Schedule::Static, ThreadPool& pool = ThreadPool::shared()) {
+    if (in.size() != out.size()) throw std::invalid_argument("Size mismatch");
+
+    Partition part = partitionRange(out.getData(), out.size(), schedule, pool);
+    pool.run(part.count, [&](size_t c) {
+        for (size_t i = part.begin(c); i < part.end(c); ++i) out[i] = f(in[i]);
+    });
+}
+
+// init reduce map(range[0]) reduce map(range[1]) ...
+template<typename T, typename R, typename Reduce, typename Map>
+R parallelTransformReduce(Span<T> range, R init, Reduce reduce, Map map, Schedule schedule = Schedule::Static, ThreadPool& pool = ThreadPool::shared()) {
+    if (range.isEmpty()) return init;
+
+    Partition part = partitionRange(range.getData(), range.size(), schedule, pool);
+    std::vector<PaddedSlot<R>> partials(part.count, PaddedSlot<R>{init});
+    pool.run(part.count, [&](size_t c) {
+        size_t i = part.begin(c);
+        R partial = map(range[i]);
+        for (++i; i < part.end(c); ++i) partial = reduce(partial, map(range[i]));
+        partials[c].value = partial;
+    });
+
+    R result = init;
+    for (const auto& partial : partials) result = reduce(result, partial.value);
+    return result;
+}
+
+template<typename T, typename R, typename Reduce = std::plus<>>
+R parallelReduce(Span<T> range, R init, Reduce reduce = Reduce{}, Schedule schedule = Schedule::Static, ThreadPool& pool = ThreadPool::shared()) {
+    return parallelTransformReduce(range, init, reduce, [](const T& element) -> R { return element; }, schedule, pool);
+}
+
+// Two passes over the same chunks: reduce each chunk, prefix the chunk totals on the calling
+// thread, then scan each chunk again starting from its carry-in
+template<bool Inclusive, typename T, typename U, typename Op>
+void scanChunks(Span<T> in, Span<U> out, U init, Op op, Schedule schedule, ThreadPool& pool) {
+    if (in.size() != out.size()) throw std::invalid_argument("Size mismatch");
+    if (in.isEmpty()) return;
+
+    Partition part = partitionRange(out.getData(), out.size(), schedule, pool);
+    std::vector<PaddedSlot<U>> carries(part.count, PaddedSlot<U>{init});
+    if (part.count > 1) {
+        pool.run(part.count - 1, [&](size_t c) { // the last chunk's total is never needed
+            size_t i = part.begin(c);
+            U total = in[i];
+            for (++i; i < part.end(c); ++i) total = op(total, in[i]);
+            carries[c + 1].value = total;
+        });
+        for (size_t c = 1; c < part.count; ++c) carries[c].value = op(carries[c - 1].value, carries[c].value);
+    }
+
+    pool.run(part.count, [&](size_t c) {
+        U running = carries[c].value;
+        for (size_t i = part.begin(c); i < part.end(c); ++i) {
+            U element = in[i]; // read before writing, so [in] and [out] can be the same span
+            if (Inclusive) {
+                running = op(running, element);
+                out[i] = running;
+            } else {
+                out[i] = running;
+                running = op(running, element);
+            }
+        }
+    });
+}
+
+// Inclusive prefix scan: out[i] = init op in[0] op ... op in[i]; [in] and [out] may be the same span
+template<typename T, typename U, typename Op = std::plus<>>
+void parallelScan(Span<T> in, Span<U> out, U init = U{}, Op op = Op{}, Schedule schedule = Schedule::Static, ThreadPool& pool = ThreadPool::shared()) {
+    scanChunks<true>(in, out, init, op, schedule, pool);
+}
+
+// Exclusive prefix scan: out[i] = init op in[0] op ... op in[i - 1]
+template<typename T, typename U, typename Op = std::plus<>>
+void parallelExclusiveScan(Span<T> in, Span<U> out, U init = U{}, Op op = Op{}, Schedule schedule = Schedule::Static, ThreadPool& pool = ThreadPool::shared()) {
+    scanChunks<false>(in, out, init, op, schedule, pool);
+}
+
+#endif
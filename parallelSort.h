@@ -0,0 +1,183 @@
+// C++ Data Structures
+
+#ifndef PARALLEL_SORT_H
+#define PARALLEL_SORT_H
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "threadPool.h"
+
+/* Parallel Sort
+- A merge sort over a contiguous range: each of [threads] chunks is std::sorted as one ThreadPool
+  task, then the sorted runs are merged pairwise, round by round, ping-ponging between the range
+  and a scratch buffer
+- Every phase goes through ThreadPool::run, so the calling thread helps and an exception thrown by
+  the comparator or a move is rethrown to the caller; the range is then left in an unspecified order
+- The first round move-constructs into the uninitialized scratch buffer, so elements are only ever
+  moved, never copied, and T needn't be default-constructible
+- Every merge is itself split across threads along its "merge path", so the last rounds (which
+  merge only a few huge runs) still keep every thread busy
+- Falls back to std::sort below parallelSortThreshold elements
+*/
+
+constexpr size_t parallelSortThreshold = 1 << 15;
+
+// Number of elements taken from [a] among the first [k] outputs of a stable merge of [a] and [b]
+template<typename T, typename Compare>
+size_t mergePathSplit(const T* a, size_t aSize, const T* b, size_t bSize, size_t k, Compare compare) {
+    size_t low = k > bSize ? k - bSize : 0;
+    size_t high = std::min(k, aSize);
+
+    while (low < high) {
+        size_t i = low + (high - low) / 2; // try taking i from [a] and k - i from [b]
+        if (compare(b[k - i - 1], a[i])) high = i; // b's last pick belongs after a[i]: take fewer from [a]
+        else low = i + 1;
+    }
+
+    return low;
+}
+
+// One thread's share of a merge round: [a, aEnd) and [b, bEnd) merged into [out, ...)
+template<typename T>
+struct MergeSegment {
+    T* a;
+    T* aEnd;
+    T* b;
+    T* bEnd;
+    T* out;
+};
+
+// Moves [value] into [slot], which is raw memory in the first round and a moved-from element after
+template<bool Construct, typename T>
+void moveInto(T* slot, T& value) {
+    if constexpr (Construct) new(slot) T(std::move(value));
+    else *slot = std::move(value);
+}
+
+// A stable merge, like std::merge over move_iterators, that can also construct into raw memory.
+// When constructing, a throwing comparison or move destroys what the segment had built so far.
+template<bool Construct, typename T, typename Compare>
+void mergeSegment(MergeSegment<T> segment, Compare compare) {
+    T* a = segment.a;
+    T* b = segment.b;
+    T* out = segment.out;
+    try {
+        while (a != segment.aEnd && b != segment.bEnd) {
+            if (compare(*b, *a)) moveInto<Construct>(out, *b++);
+            else moveInto<Construct>(out, *a++);
+            ++out;
+        }
+        for (; a != segment.aEnd; ++out) moveInto<Construct>(out, *a++);
+        for (; b != segment.bEnd; ++out) moveInto<Construct>(out, *b++);
+    } catch (...) {
+        if constexpr (Construct) std::destroy(segment.out, out);
+        throw;
+    }
+}
+
+// Size of the output [segment] writes
+template<typename T>
+size_t segmentSize(const MergeSegment<T>& segment) {
+    return (segment.aEnd - segment.a) + (segment.bEnd - segment.b);
+}
+
+template<typename T, typename Compare = std::less<T>>
+void parallelSort(T* first, T* last, unsigned threads = std::thread::hardware_concurrency(), Compare compare = Compare{},
+                  ThreadPool& pool = ThreadPool::shared()) {
+    size_t n = last - first;
+    if (threads <= 1 || n < parallelSortThreshold) {
+        std::sort(first, last, compare);
+        return;
+    }
+
+    threads = (unsigned) std::min<size_t>(threads, n / (parallelSortThreshold / 2));
+
+    // Phase 1: sort [threads] chunks independently
+    std::vector<size_t> runStarts;
+    for (unsigned t = 0; t <= threads; ++t)
+        runStarts.push_back(n * t / threads);
+
+    pool.run(threads, [&](size_t t) { std::sort(first + runStarts[t], first + runStarts[t + 1], compare); });
+
+    // Phase 2: merge neighbouring runs until one is left
+    struct Scratch { // raw memory until the first round has constructed every element in it
+        std::allocator<T> allocator;
+        T* data;
+        size_t size;
+        bool constructed = false;
+
+        explicit Scratch(size_t size) : data{allocator.allocate(size)}, size{size} {}
+        ~Scratch() {
+            if (constructed) std::destroy_n(data, size);
+            allocator.deallocate(data, size);
+        }
+    } scratch{n};
+    T* from = first;
+    T* to = scratch.data;
+
+    while (runStarts.size() > 2) {
+        std::vector<size_t> mergedStarts;
+        size_t merges = (runStarts.size() - 1) / 2;
+        size_t segmentsPerMerge = std::max<size_t>(1, threads / std::max<size_t>(1, merges));
+
+        // Every split is found before any task starts moving elements out of [from]
+        std::vector<MergeSegment<T>> segments;
+        for (size_t r = 0; r + 1 < runStarts.size(); r += 2) {
+            size_t aStart = runStarts[r];
+            mergedStarts.push_back(aStart);
+
+            if (r + 2 >= runStarts.size()) { // odd run out: carry it over unmerged
+                size_t aEnd = runStarts[r + 1];
+                segments.push_back(MergeSegment<T>{from + aStart, from + aEnd, from + aEnd, from + aEnd, to + aStart});
+                continue;
+            }
+
+            T* a = from + aStart;
+            T* b = from + runStarts[r + 1];
+            size_t aSize = b - a;
+            size_t bSize = runStarts[r + 2] - runStarts[r + 1];
+            size_t total = aSize + bSize;
+
+            for (size_t s = 0; s < segmentsPerMerge; ++s) {
+                size_t outBegin = total * s / segmentsPerMerge;
+                size_t outEnd = total * (s + 1) / segmentsPerMerge;
+                size_t aBegin = mergePathSplit(a, aSize, b, bSize, outBegin, compare);
+                size_t aEnd = mergePathSplit(a, aSize, b, bSize, outEnd, compare);
+                segments.push_back(MergeSegment<T>{a + aBegin, a + aEnd, b + (outBegin - aBegin), b + (outEnd - aEnd), to + aStart + outBegin});
+            }
+        }
+        mergedStarts.push_back(n);
+
+        if (scratch.constructed) {
+            pool.run(segments.size(), [&](size_t s) { mergeSegment<false>(segments[s], compare); });
+        } else { // the first round writes into raw scratch memory
+            std::vector<char> built(segments.size(), false); // not vector<bool>, whose bits would race
+            try {
+                pool.run(segments.size(), [&](size_t s) {
+                    mergeSegment<true>(segments[s], compare);
+                    built[s] = true;
+                });
+            } catch (...) { // a failed segment cleaned up after itself; the finished ones are destroyed here
+                for (size_t s = 0; s < segments.size(); ++s)
+                    if (built[s]) std::destroy_n(segments[s].out, segmentSize(segments[s]));
+                throw;
+            }
+            scratch.constructed = true; // the segments cover every output, so all n now exist
+        }
+
+        runStarts = std::move(mergedStarts);
+        std::swap(from, to);
+    }
+
+    if (from != first) { // the result ended up in the scratch buffer
+        pool.run(threads, [&](size_t t) { std::move(from + n * t / threads, from + n * (t + 1) / threads, first + n * t / threads); });
+    }
+}
+
+#endif
@@ -7,7 +7,20 @@
 #define LOG(x)
 #endif
 
+#include <atomic>
 #include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "nodeAllocation.h"
+#include "nodePool.h"
+#include "workStealing.h"
 
 template<typename T>
 class Queue {
@@ -19,13 +32,17 @@ class Queue {
     Node* pHead;
     Node* pTail;
     size_t pSize;
+    std::pmr::memory_resource* resource;
+    NodePool nodePool; // every node comes from here; [resource] only supplies its slabs
 
     public:
         Queue();
+        explicit Queue(std::pmr::memory_resource* resource); // e.g. a per-request arena or a pool
         Queue(const Queue& other);
         Queue(Queue&& other);
         Queue& operator=(const Queue& other);
         Queue& operator=(Queue&& other);
+        std::pmr::memory_resource* getResource() const;
         T& front();
         const T& front() const;
         T& back();
@@ -56,23 +73,27 @@ class Queue {
 };
 
 template<typename T>
-Queue<T>::Queue() : pHead{nullptr}, pTail{nullptr}, pSize{0} {}
+Queue<T>::Queue() : Queue{std::pmr::get_default_resource()} {}
 
 template<typename T>
-Queue<T>::Queue(const Queue& other) : pHead{nullptr}, pTail{nullptr}, pSize{0} {
+Queue<T>::Queue(std::pmr::memory_resource* resource) : pHead{nullptr}, pTail{nullptr}, pSize{0}, resource{resource}, nodePool{sizeof(Node), alignof(Node), resource} {}
+
+template<typename T>
+Queue<T>::Queue(const Queue& other) : pHead{nullptr}, pTail{nullptr}, pSize{0}, resource{std::pmr::get_default_resource()},
+    nodePool{sizeof(Node), alignof(Node), resource} {
     Node* otherTraverser = other.pHead;
     Node* thisTraverser = nullptr;
     Node* thisNextTraverser = nullptr;
 
     if (otherTraverser) {
-        pHead = new Node{otherTraverser->data, nullptr};
+        pHead = createNode<Node>(&nodePool, otherTraverser->data, nullptr);
         thisTraverser = pHead;
     }
 
     while (otherTraverser) {
         ++pSize;
         otherTraverser = otherTraverser->next;
-        thisNextTraverser = otherTraverser? new Node{otherTraverser->data, nullptr} : otherTraverser;
+        thisNextTraverser = otherTraverser? createNode<Node>(&nodePool, otherTraverser->data, nullptr) : otherTraverser;
         thisTraverser->next = thisNextTraverser;
         if (thisNextTraverser) thisTraverser = thisTraverser->next;
     }
@@ -81,7 +102,7 @@ Queue<T>::Queue(const Queue& other) : pHead{nullptr}, pTail{nullptr}, pSize{0} {
 }
 
 template<typename T>
-Queue<T>::Queue(Queue&& other) : pHead{other.pHead}, pTail{other.pTail}, pSize{other.pSize} {
+Queue<T>::Queue(Queue&& other) : pHead{other.pHead}, pTail{other.pTail}, pSize{other.pSize}, resource{other.resource}, nodePool{std::move(other.nodePool)} {
     other.pHead = nullptr;
     other.pTail = nullptr;
     other.pSize = 0;
@@ -97,14 +118,14 @@ Queue<T>& Queue<T>::operator=(const Queue& other) {
     Node* thisNextTraverser = nullptr;
 
     if (otherTraverser) {
-        pHead = new Node{otherTraverser->data, nullptr};
+        pHead = createNode<Node>(&nodePool, otherTraverser->data, nullptr);
         thisTraverser = pHead;
     }
 
     while (otherTraverser) {
         ++pSize;
         otherTraverser = otherTraverser->next;
-        thisNextTraverser = otherTraverser? new Node{otherTraverser->data, nullptr} : otherTraverser;
+        thisNextTraverser = otherTraverser? createNode<Node>(&nodePool, otherTraverser->data, nullptr) : otherTraverser;
         thisTraverser->next = thisNextTraverser;
         if (thisNextTraverser) thisTraverser = thisTraverser->next;
     }
@@ -119,10 +140,15 @@ Queue<T>& Queue<T>::operator=(Queue&& other) {
     std::swap(pHead, other.pHead);
     std::swap(pTail, other.pTail);
     std::swap(pSize, other.pSize);
+    std::swap(resource, other.resource);
+    nodePool.swap(other.nodePool); // the nodes must go back to the pool they came from
 
     return *this;
 }
 
+template<typename T>
+std::pmr::memory_resource* Queue<T>::getResource() const { return resource; }
+
 template<typename T>
 T& Queue<T>::front() {
     if (!pHead) throw std::invalid_argument("Queue head is NULL");
@@ -149,7 +175,7 @@ const T& Queue<T>::back() const {
 
 template<typename T>
 void Queue<T>::push_back(const T& elem) {
-    Node* newNode = new Node{elem, nullptr};
+    Node* newNode = createNode<Node>(&nodePool, elem, nullptr);
 
     if (pSize == 0) {
         pHead = newNode;
@@ -164,7 +190,7 @@ void Queue<T>::push_back(const T& elem) {
 
 template<typename T>
 void Queue<T>::push_back(T&& elem) {
-    Node* newNode = new Node{std::move(elem), nullptr};
+    Node* newNode = createNode<Node>(&nodePool, std::move(elem), nullptr);
 
     if (pSize == 0) {
         pHead = newNode;
@@ -183,7 +209,7 @@ void Queue<T>::pop_front() {
     pHead = pHead->next;
 
     --pSize;
-    delete toBeDeleted;
+    destroyNode(&nodePool, toBeDeleted);
 }
 
 template<typename T>
@@ -237,14 +263,11 @@ std::ostream& operator<<(std::ostream& out, const Queue<T>& qu) {
 
 template<typename T>
 void Queue<T>::clear() {
-    Node* traverser = pHead;
-    Node* tempNode = nullptr;
-
-    while(traverser) {
-        tempNode = traverser->next;
-        delete traverser;
-        traverser = tempNode;
+    if constexpr (!std::is_trivially_destructible<T>::value) {
+        for (Node* traverser = pHead; traverser; traverser = traverser->next)
+            traverser->data.~T();
     }
+    nodePool.release(); // hands back whole slabs instead of freeing node by node
 
     pSize = 0;
     pHead = nullptr;
@@ -253,14 +276,233 @@ void Queue<T>::clear() {
 
 template<typename T>
 Queue<T>::~Queue() {
-    Node* traverser = pHead;
-    Node* tempNode = nullptr;
+    if constexpr (!std::is_trivially_destructible<T>::value) {
+        for (Node* traverser = pHead; traverser; traverser = traverser->next)
+            traverser->data.~T();
+    }
+    // nodePool hands back whole slabs when it's destroyed
+}
+
+/* Persistent Queue
+- An immutable queue with O(1) copies, for snapshotting: Okasaki's real-time queue
+- Elements are pushed onto a rear list and popped from a front stream. When the rear grows one
+  longer than the front, front ++ reverse(rear) becomes the new front, but lazily: each cell of it
+  is built only when something forces it
+- Every push and pop forces exactly one pending cell (the schedule), so the rotation is paid off
+  one step at a time and each operation is O(1) in the worst case, even when old versions are
+  used again (a plain two-list queue can redo a whole reversal on every pop from one snapshot)
+- Cells are reference counted and shared between versions; forcing one fills it in place, so
+  every version that shares it sees the result. Because of that, versions sharing cells must be
+  used from one thread at a time
+- Elements are copied as the rotation builds the new front, so T must be copyable
+- Nodes come from [resource], which copies share and which must outlive all of them
+*/
+
+template<typename T>
+class PersistentQueue {
+    struct ListNode { // the rear, newest first
+        T data;
+        std::shared_ptr<ListNode> next;
+
+        template<typename... Args>
+        ListNode(std::shared_ptr<ListNode> next, Args&&... args) : data(std::forward<Args>(args)...), next{std::move(next)} {}
+        ~ListNode();
+    };
+
+    struct StreamNode { // a front cell: either forced (data, next) or a pending rotate(front, rear, accumulated)
+        std::optional<T> data;
+        std::shared_ptr<StreamNode> next;
+        std::shared_ptr<StreamNode> front;
+        std::shared_ptr<ListNode> rear;
+        std::shared_ptr<StreamNode> accumulated;
+
+        ~StreamNode();
+    };
+
+    std::shared_ptr<StreamNode> pFront;
+    std::shared_ptr<ListNode> pRear;
+    std::shared_ptr<StreamNode> schedule; // the first unforced cell of pFront, if any
+    size_t frontSize;
+    size_t rearSize;
+    std::pmr::memory_resource* resource;
+
+        std::shared_ptr<StreamNode> makeCell();
+        void force(StreamNode* cell);
+        void step(); // forces one cell, or starts a rotation once the rear outgrows the front
+    public:
+        PersistentQueue();
+        explicit PersistentQueue(std::pmr::memory_resource* resource);
+        std::pmr::memory_resource* getResource() const;
+        const T& front();
+        void push_back(const T& elem);
+        void push_back(T&& elem);
+        template<typename... args>
+        void emplace_back(args&&... myArgs);
+        void pop_front(); // does nothing when empty
+        size_t size() const;
+        bool isEmpty() const;
+        template <typename U>
+        friend std::ostream& operator<<(std::ostream& out, PersistentQueue<U>& qu);
+        void clear();
+};
+
+// Both unlink the nodes no other version uses one at a time, so long chains can't overflow the call stack
+template<typename T>
+PersistentQueue<T>::ListNode::~ListNode() {
+    std::shared_ptr<ListNode> rest = std::move(next);
+    while (rest && rest.use_count() == 1) {
+        std::atomic_thread_fence(std::memory_order_acquire); // use_count() is relaxed: order the last other owner's reads before we write
+        rest = std::move(rest->next);
+    }
+}
+
+template<typename T>
+PersistentQueue<T>::StreamNode::~StreamNode() {
+    std::shared_ptr<StreamNode> rest = std::move(next);
+    while (rest && rest.use_count() == 1) {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        rest = std::move(rest->next);
+    }
+}
+
+template<typename T>
+PersistentQueue<T>::PersistentQueue() : PersistentQueue{std::pmr::get_default_resource()} {}
+
+template<typename T>
+PersistentQueue<T>::PersistentQueue(std::pmr::memory_resource* resource) : pFront{nullptr}, pRear{nullptr}, schedule{nullptr},
+    frontSize{0}, rearSize{0}, resource{resource} {}
+
+template<typename T>
+std::shared_ptr<typename PersistentQueue<T>::StreamNode> PersistentQueue<T>::makeCell() {
+    return std::allocate_shared<StreamNode>(std::pmr::polymorphic_allocator<StreamNode>{resource});
+}
+
+// rotate(f, r, a) = f ++ reverse(r) ++ a, where r is one longer than f:
+//   rotate([], [y], a) = y : a
+//   rotate(x : f, y : r, a) = x : rotate(f, r, y : a)
+// Earlier steps have already forced every cell of f, so this is O(1)
+template<typename T>
+void PersistentQueue<T>::force(StreamNode* cell) {
+    if (cell->data) return;
+
+    std::shared_ptr<StreamNode> next;
+    std::optional<T> value;
+    if (!cell->front) {
+        value.emplace(cell->rear->data);
+        next = cell->accumulated;
+    } else {
+        force(cell->front.get());
+        value.emplace(*cell->front->data);
+
+        std::shared_ptr<StreamNode> consumed = makeCell(); // y : a, already forced
+        consumed->data.emplace(cell->rear->data);
+        consumed->next = cell->accumulated;
+
+        next = makeCell(); // rotate(f, r, y : a), left pending
+        next->front = cell->front->next;
+        next->rear = cell->rear->next;
+        next->accumulated = std::move(consumed);
+    }
+
+    // Nothing above changed the cell, so a throwing copy or allocation leaves it pending
+    cell->data = std::move(value);
+    cell->next = std::move(next);
+    cell->front = nullptr;
+    cell->rear = nullptr;
+    cell->accumulated = nullptr;
+}
 
-    while(traverser) {
-        tempNode = traverser->next;
-        delete traverser;
-        traverser = tempNode;
+template<typename T>
+void PersistentQueue<T>::step() {
+    if (schedule) {
+        force(schedule.get());
+        schedule = schedule->next;
+        return;
     }
+
+    std::shared_ptr<StreamNode> rotated = makeCell(); // the schedule ran out, so the rear is one longer than the front
+    rotated->front = pFront;
+    rotated->rear = pRear;
+    pFront = rotated;
+    schedule = std::move(rotated);
+    pRear = nullptr;
+    frontSize += rearSize;
+    rearSize = 0;
+}
+
+template<typename T>
+std::pmr::memory_resource* PersistentQueue<T>::getResource() const { return resource; }
+
+template<typename T>
+const T& PersistentQueue<T>::front() {
+    if (!pFront) throw std::invalid_argument("Queue head is NULL");
+    force(pFront.get());
+    return *pFront->data;
+}
+
+template<typename T>
+void PersistentQueue<T>::push_back(const T& elem) {
+    emplace_back(elem);
+}
+
+template<typename T>
+void PersistentQueue<T>::push_back(T&& elem) {
+    emplace_back(std::move(elem));
+}
+
+template<typename T>
+template<typename... args>
+void PersistentQueue<T>::emplace_back(args&&... myArgs) {
+    pRear = std::allocate_shared<ListNode>(std::pmr::polymorphic_allocator<ListNode>{resource}, pRear, std::forward<args>(myArgs)...);
+    ++rearSize;
+    step();
+}
+
+template<typename T>
+void PersistentQueue<T>::pop_front() {
+    if (!pFront) return;
+    force(pFront.get());
+    pFront = pFront->next;
+    --frontSize;
+    step();
+}
+
+template<typename T>
+size_t PersistentQueue<T>::size() const { return frontSize + rearSize; }
+
+template<typename T>
+bool PersistentQueue<T>::isEmpty() const { return size() == 0; }
+
+// Forces the whole front, so printing costs O(n) once per version
+template<typename T>
+std::ostream& operator<<(std::ostream& out, PersistentQueue<T>& qu) {
+    out << "{";
+    bool first = true;
+    for (auto cell = qu.pFront; cell; cell = cell->next) {
+        qu.force(cell.get());
+        if (!first) out << ", ";
+        out << *cell->data;
+        first = false;
+    }
+
+    std::vector<const T*> rear; // newest first, so print it backwards
+    for (auto node = qu.pRear.get(); node; node = node->next.get()) rear.push_back(&node->data);
+    for (auto it = rear.rbegin(); it != rear.rend(); ++it) {
+        if (!first) out << ", ";
+        out << **it;
+        first = false;
+    }
+    out << "}";
+    return out;
+}
+
+template<typename T>
+void PersistentQueue<T>::clear() {
+    pFront = nullptr; // other versions keep the cells they share
+    pRear = nullptr;
+    schedule = nullptr;
+    frontSize = 0;
+    rearSize = 0;
 }
 
 Queue<std::string> getNewQueue() {
@@ -305,6 +547,103 @@ void testQueueClass() {
     std::cout << examsHandedIn << std::endl;
     std::cout << drillLine << std::endl;
 
+    std::pmr::unsynchronized_pool_resource nodePool;
+    Queue<std::string> printJobs{&nodePool};
+    printJobs.push_back("report.pdf");
+    printJobs.push_back("slides.pdf");
+    printJobs.pop_front();
+    printJobs.push_back("notes.txt");
+    std::cout << printJobs << std::endl;
+
+    // The owner pushes and pops at the bottom while thieves steal from the top
+    WorkStealingDeque<int> jobs{4}; // small, so it has to grow
+    std::atomic<bool> producing{true};
+    std::atomic<long long> stolenSum{0};
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < 3; ++t) {
+        thieves.emplace_back([&] {
+            int job;
+            long long sum = 0;
+            while (producing.load() || !jobs.isEmpty())
+                if (jobs.steal(job)) sum += job;
+            stolenSum += sum;
+        });
+    }
+    long long ownSum = 0;
+    for (int i = 1; i <= 100000; ++i) {
+        jobs.push(i);
+        int job;
+        if (i % 3 == 0 && jobs.pop(job)) ownSum += job;
+    }
+    producing = false;
+    for (auto& thief : thieves) thief.join();
+    LOG("Every job ran once: " << (ownSum + stolenSum == 100000LL * 100001 / 2))
+
+    // Fork-join on the work-stealing scheduler
+    WorkStealingScheduler scheduler{4};
+    std::vector<long long> squares(1 << 16);
+    forkJoinFor(0, squares.size(), 1024, [&](size_t i) { squares[i] = (long long) i * i; }, scheduler);
+    LOG("Squares: " << squares[3] << " " << squares.back())
+
+    std::atomic<size_t> visited{0};
+    try {
+        forkJoinFor(0, 1 << 14, 64, [&](size_t i) {
+            if (i == 0) throw std::invalid_argument("Bad record"); // on the calling thread, with tasks still queued
+            ++visited;
+        }, scheduler);
+    } catch (const std::invalid_argument& e) {
+        LOG("Caller threw: " << e.what() << ", queued tasks still finished: " << (visited > 0))
+    }
+
+    std::function<long long(int)> fib = [&](int n) -> long long {
+        if (n < 16) return n < 2 ? n : fib(n - 1) + fib(n - 2);
+        long long left = 0;
+        TaskGroup group{scheduler};
+        group.spawn([&] { left = fib(n - 1); });
+        long long right = fib(n - 2);
+        group.wait(); // runs other tasks meanwhile, so nesting can't deadlock
+        return left + right;
+    };
+    LOG("fib(25) = " << fib(25))
+
+    TaskGroup failing{scheduler};
+    failing.spawn([] { throw std::out_of_range("Invalid index"); });
+    try {
+        failing.wait();
+    } catch (const std::out_of_range& e) {
+        LOG("Task threw: " << e.what())
+    }
+
+    PersistentQueue<std::string> frontier; // a search frontier, snapshotted before each expansion
+    frontier.push_back("root");
+    frontier.push_back("left");
+    frontier.push_back("right");
+    PersistentQueue<std::string> beforeExpand = frontier; // O(1)
+    frontier.pop_front();
+    frontier.emplace_back(2, 'x'); // "xx"
+    std::cout << frontier << " " << beforeExpand << std::endl;
+
+    PersistentQueue<int> events;
+    std::vector<PersistentQueue<int>> checkpoints;
+    long long expected = 0;
+    bool inOrder = true;
+    for (int i = 0; i < 300000; ++i) {
+        events.push_back(i);
+        if (i % 3 == 2) {
+            inOrder = inOrder && events.front() == expected++;
+            events.pop_front();
+        }
+        if (i % 10000 == 0) checkpoints.push_back(events);
+    }
+    for (int round = 0; round < 3; ++round) { // draining an old version repeatedly does no extra work
+        PersistentQueue<int> replay = checkpoints[checkpoints.size() / 2];
+        long long head = replay.front();
+        while (!replay.isEmpty()) {
+            inOrder = inOrder && replay.front() == head++;
+            replay.pop_front();
+        }
+    }
+    LOG("In order: " << inOrder << ", " << events.size() << " left, oldest checkpoint holds " << checkpoints.front().size())
 }
 
 int main() {
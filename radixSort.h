@@ -0,0 +1,117 @@
+// C++ Data Structures
+
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+/* Radix Sort
+- LSD radix sort on 8-bit digits: one sweep builds the histogram of every digit, then each pass
+  scatters the elements stably between the range and a scratch buffer (ping-pong)
+- Keys are mapped to unsigned integers that compare the same way: signed integers get their sign
+  bit flipped, floats get every bit flipped when negative and just the sign bit otherwise
+- Passes whose digit is the same for every key are skipped, so narrow-range keys (small ints in a
+  64-bit type, timestamps sharing their top bytes) only pay for the digits that actually differ
+- Falls back to std::sort below radixSortThreshold elements, where the histograms don't pay off
+*/
+
+constexpr size_t radixSortThreshold = 1 << 11;
+
+// Integers and float/double: types whose bits can be turned into an order-preserving unsigned key
+template<typename K>
+constexpr bool isRadixSortable = std::is_integral<K>::value ||
+    (std::is_floating_point<K>::value && (sizeof(K) == 4 || sizeof(K) == 8));
+
+template<size_t Bytes> struct RadixKeyType;
+template<> struct RadixKeyType<1> { typedef uint8_t type; };
+template<> struct RadixKeyType<2> { typedef uint16_t type; };
+template<> struct RadixKeyType<4> { typedef uint32_t type; };
+template<> struct RadixKeyType<8> { typedef uint64_t type; };
+
+template<typename K>
+using RadixKey = typename RadixKeyType<sizeof(K)>::type;
+
+// Maps [key] to an unsigned integer so that a < b exactly when radixKey(a) < radixKey(b)
+template<typename K>
+RadixKey<K> radixKey(K key) {
+    static_assert(isRadixSortable<K>, "radix sort needs an integer, float or double key");
+    typedef RadixKey<K> U;
+    constexpr U signBit = U(1) << (sizeof(K) * 8 - 1);
+
+    U bits;
+    std::memcpy(&bits, &key, sizeof(K));
+
+    if constexpr (std::is_floating_point<K>::value) return (bits & signBit) ? U(~bits) : U(bits | signBit);
+    else if constexpr (std::is_signed<K>::value) return bits ^ signBit;
+    else return bits;
+}
+
+// Stable sort of [first, last) by keyOf(element), which must return an integer, float or double
+template<typename T, typename KeyOf>
+void radixSortByKey(T* first, T* last, KeyOf keyOf) {
+    typedef std::decay_t<decltype(keyOf(*first))> K;
+    constexpr size_t passes = sizeof(K);
+    size_t n = last - first;
+
+    if (n < radixSortThreshold) {
+        std::stable_sort(first, last, [&](const T& a, const T& b) { return radixKey(keyOf(a)) < radixKey(keyOf(b)); });
+        return;
+    }
+
+    std::vector<size_t> counts(passes * 256, 0);
+    for (size_t i = 0; i < n; ++i) {
+        RadixKey<K> key = radixKey(keyOf(first[i]));
+        for (size_t pass = 0; pass < passes; ++pass)
+            ++counts[pass * 256 + ((key >> (pass * 8)) & 0xFF)];
+    }
+
+    std::vector<T> scratch(std::make_move_iterator(first), std::make_move_iterator(last));
+    T* from = scratch.data();
+    T* to = first;
+    bool inScratch = true; // where the live elements are right now
+
+    for (size_t pass = 0; pass < passes; ++pass) {
+        size_t* digitCounts = &counts[pass * 256];
+        if (std::find(digitCounts, digitCounts + 256, n) != digitCounts + 256) continue; // every key shares this digit
+
+        size_t offset = 0;
+        for (size_t digit = 0; digit < 256; ++digit) { // counts -> starting offsets
+            size_t count = digitCounts[digit];
+            digitCounts[digit] = offset;
+            offset += count;
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            size_t digit = (radixKey(keyOf(from[i])) >> (pass * 8)) & 0xFF;
+            to[digitCounts[digit]++] = std::move(from[i]);
+        }
+
+        std::swap(from, to);
+        inScratch = !inScratch;
+    }
+
+    if (inScratch) std::move(scratch.begin(), scratch.end(), first);
+}
+
+template<typename T>
+void radixSort(T* first, T* last) {
+    if (size_t(last - first) < radixSortThreshold) {
+        std::sort(first, last);
+        return;
+    }
+    radixSortByKey(first, last, [](const T& element) { return element; });
+}
+
+// What Array::sort/Vector::sort use: radix sort for integer and float elements, std::sort otherwise
+template<typename T>
+void sortRange(T* first, T* last) {
+    if constexpr (isRadixSortable<T>) radixSort(first, last);
+    else std::sort(first, last);
+}
+
+#endif
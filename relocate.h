@@ -0,0 +1,156 @@
+// C++ Data Structures
+
+#ifndef RELOCATE_H
+#define RELOCATE_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// "Relocating" an object = move-constructing it into new storage and destroying the original.
+// For trivially copyable types this is just a byte copy, so whole ranges can be moved with
+// a single memcpy/memmove and malloc'd buffers can be grown in place with realloc (which uses
+// mremap for very large, mmap-backed blocks).
+
+template<typename T>
+constexpr bool isTriviallyRelocatable = std::is_trivially_copyable<T>::value;
+
+// The default memory resource for contiguous buffers: the malloc heap, which (unlike an
+// arbitrary memory_resource) can grow a block in place with realloc
+class HeapResource : public std::pmr::memory_resource {
+        static constexpr bool isMallocAligned(size_t alignment) { return alignment <= alignof(std::max_align_t); }
+
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            if (!isMallocAligned(alignment)) return ::operator new(bytes, std::align_val_t{alignment});
+
+            void* memory = std::malloc(bytes ? bytes : 1);
+            if (!memory) throw std::bad_alloc();
+            return memory;
+        }
+
+        void do_deallocate(void* memory, size_t bytes, size_t alignment) override {
+            if (!isMallocAligned(alignment)) return ::operator delete(memory, bytes, std::align_val_t{alignment});
+            std::free(memory);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    public:
+        bool canReallocate(size_t alignment) const { return isMallocAligned(alignment); }
+
+        void* reallocate(void* memory, size_t newBytes) {
+            void* resized = std::realloc(memory, newBytes ? newBytes : 1);
+            if (!resized) throw std::bad_alloc();
+            return resized;
+        }
+};
+
+inline HeapResource* heapResource() {
+    static HeapResource resource;
+    return &resource;
+}
+
+// [alignment] can be raised above alignof(T), e.g. to a cache line for SIMD-friendly columns
+template<typename T>
+T* allocateBuffer(size_t count, std::pmr::memory_resource* resource, size_t alignment = alignof(T)) {
+    if (count == 0) return nullptr;
+    return (T*) resource->allocate(sizeof(T) * count, alignment);
+}
+
+template<typename T>
+void deallocateBuffer(T* buffer, size_t count, std::pmr::memory_resource* resource, size_t alignment = alignof(T)) {
+    if (!buffer) return;
+    resource->deallocate(buffer, sizeof(T) * count, alignment);
+}
+
+template<typename T>
+void destroyRange(T* first, size_t count) {
+    if constexpr (!std::is_trivially_destructible<T>::value) {
+        for (size_t i = 0; i < count; ++i)
+            first[i].~T();
+    }
+}
+
+// Copy-constructs [count] elements starting at [from] into uninitialized memory at [to, to + count).
+// [from] can be any iterator; move_iterators move-construct instead.
+template<typename It, typename T>
+void uninitializedCopy(It from, size_t count, T* to) {
+    if constexpr (isTriviallyRelocatable<T> && std::is_pointer<It>::value &&
+                  std::is_same<std::remove_cv_t<std::remove_pointer_t<It>>, T>::value) {
+        if (count) std::memcpy((void*) to, (const void*) from, sizeof(T) * count);
+    } else {
+        size_t i = 0;
+        try {
+            for (; i < count; ++i, ++from)
+                new(&to[i]) T(*from);
+        } catch (...) {
+            destroyRange(to, i);
+            throw;
+        }
+    }
+}
+
+// Relocates [from, from + count) into uninitialized, non-overlapping memory at [to, to + count).
+// The source range is left uninitialized.
+template<typename T>
+void relocateRange(T* from, size_t count, T* to) {
+    if constexpr (isTriviallyRelocatable<T>) {
+        if (count) std::memcpy((void*) to, (const void*) from, sizeof(T) * count);
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            new(&to[i]) T(std::move(from[i]));
+            from[i].~T();
+        }
+    }
+}
+
+// Opens a gap of [gap] uninitialized slots at [pos] by relocating [pos, size) up by [gap].
+// The buffer must have room for size + gap elements.
+template<typename T>
+void shiftRight(T* data, size_t size, size_t pos, size_t gap) {
+    if (gap == 0 || pos >= size) return;
+
+    if constexpr (isTriviallyRelocatable<T>) {
+        std::memmove((void*) (data + pos + gap), (const void*) (data + pos), sizeof(T) * (size - pos));
+    } else {
+        for (size_t i = size; i > pos; --i) { // back to front so nothing is overwritten
+            new(&data[i - 1 + gap]) T(std::move(data[i - 1]));
+            data[i - 1].~T();
+        }
+    }
+}
+
+// Closes a gap of [gap] uninitialized slots at [pos] by relocating [pos + gap, size) down by [gap].
+template<typename T>
+void shiftLeft(T* data, size_t size, size_t pos, size_t gap) {
+    if (gap == 0 || pos + gap >= size) return;
+
+    if constexpr (isTriviallyRelocatable<T>) {
+        std::memmove((void*) (data + pos), (const void*) (data + pos + gap), sizeof(T) * (size - pos - gap));
+    } else {
+        for (size_t i = pos + gap; i < size; ++i) {
+            new(&data[i - gap]) T(std::move(data[i]));
+            data[i].~T();
+        }
+    }
+}
+
+// Grows/shrinks a buffer holding [size] live elements from [oldCap] to [newCap] slots.
+// Trivially relocatable buffers on the HeapResource are resized in place with realloc.
+template<typename T>
+T* reallocateBuffer(T* buffer, size_t size, size_t oldCap, size_t newCap, std::pmr::memory_resource* resource) {
+    if constexpr (isTriviallyRelocatable<T>) {
+        if (buffer && newCap && resource == heapResource() && heapResource()->canReallocate(alignof(T)))
+            return (T*) heapResource()->reallocate(buffer, sizeof(T) * newCap);
+    }
+
+    T* resized = allocateBuffer<T>(newCap, resource);
+    relocateRange(buffer, size, resized);
+    deallocateBuffer(buffer, oldCap, resource);
+    return resized;
+}
+
+#endif
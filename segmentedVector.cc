@@ -0,0 +1,563 @@
+// C++ Data Structures
+
+#define DEBUG_MODE 1
+#if DEBUG_MODE
+#define LOG(x) std::cout << x << std::endl;
+#else
+#define LOG(x)
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "relocate.h"
+
+/* Segmented Vector
+- A deque-style vector: elements live in fixed-size blocks, found through a directory of block
+  pointers, so growing never copies or moves an element
+- push_back/push_front allocate at most one block; only the directory (one pointer per block)
+  is ever reallocated, which keeps every append's worst case tiny even at 10^8+ elements
+- Random access is a shift and a mask into the directory; references stay valid on push/pop at
+  either end
+- One emptied block is kept as a spare, so push/pop across a block boundary doesn't thrash
+*/
+
+// A power of two that keeps each block around 4 KiB
+template<typename T>
+constexpr size_t defaultBlockSize() {
+    size_t target = std::max<size_t>(16, 4096 / sizeof(T));
+    size_t size = 1;
+    while (size * 2 <= target) size *= 2;
+    return size;
+}
+
+template<typename T, size_t BlockSize = defaultBlockSize<T>()>
+class SegmentedVector {
+    static_assert(BlockSize > 0 && (BlockSize & (BlockSize - 1)) == 0, "BlockSize must be a power of two");
+
+    T** directory;
+    size_t dirCapacity;
+    size_t firstBlock; // directory slots [firstBlock, firstBlock + blockCount) hold blocks
+    size_t blockCount;
+    size_t head; // offset of the first element within the first block
+    size_t vecSize;
+    T* spare;
+    std::pmr::memory_resource* resource;
+
+        T* allocateBlock();
+        void freeBlock(T* block);
+        void growDirectory(bool atFront);
+        void addBlockAtBack();
+        void addBlockAtFront();
+        void release();
+    public:
+        template<typename U>
+        class BasicIterator { // random access, so std::sort and friends work
+            typedef std::conditional_t<std::is_const<U>::value, const SegmentedVector*, SegmentedVector*> Owner;
+            Owner v;
+            size_t index;
+            public:
+                typedef std::random_access_iterator_tag iterator_category;
+                typedef std::remove_const_t<U> value_type;
+                typedef std::ptrdiff_t difference_type;
+                typedef U* pointer;
+                typedef U& reference;
+
+                BasicIterator() : v{nullptr}, index{0} {}
+                BasicIterator(Owner v, size_t index) : v{v}, index{index} {}
+                U& operator*() const { return (*v)[index]; }
+                U* operator->() const { return &(*v)[index]; }
+                U& operator[](difference_type n) const { return (*v)[index + n]; }
+                BasicIterator& operator++() { ++index; return *this; }
+                BasicIterator operator++(int) { BasicIterator old = *this; ++index; return old; }
+                BasicIterator& operator--() { --index; return *this; }
+                BasicIterator operator--(int) { BasicIterator old = *this; --index; return old; }
+                BasicIterator& operator+=(difference_type n) { index += n; return *this; }
+                BasicIterator& operator-=(difference_type n) { index -= n; return *this; }
+                BasicIterator operator+(difference_type n) const { return BasicIterator{v, index + n}; }
+                BasicIterator operator-(difference_type n) const { return BasicIterator{v, index - n}; }
+                friend BasicIterator operator+(difference_type n, const BasicIterator& it) { return it + n; }
+                difference_type operator-(const BasicIterator& other) const { return (difference_type) index - (difference_type) other.index; }
+                bool operator==(const BasicIterator& other) const { return index == other.index; }
+                bool operator!=(const BasicIterator& other) const { return index != other.index; }
+                bool operator<(const BasicIterator& other) const { return index < other.index; }
+                bool operator>(const BasicIterator& other) const { return index > other.index; }
+                bool operator<=(const BasicIterator& other) const { return index <= other.index; }
+                bool operator>=(const BasicIterator& other) const { return index >= other.index; }
+        };
+        typedef BasicIterator<T> Iterator;
+        typedef BasicIterator<const T> ConstIterator;
+
+        SegmentedVector();
+        explicit SegmentedVector(std::pmr::memory_resource* resource);
+        SegmentedVector(const SegmentedVector& other);
+        SegmentedVector(const SegmentedVector& other, std::pmr::memory_resource* resource);
+        SegmentedVector(SegmentedVector&& other);
+        SegmentedVector& operator=(const SegmentedVector& other);
+        SegmentedVector& operator=(SegmentedVector&& other);
+        size_t size() const;
+        std::pmr::memory_resource* getResource() const;
+        void shrink_to_fit(); // frees the spare block and trims the directory; frees everything when empty
+        T& operator[](size_t index);
+        const T& operator[](size_t index) const;
+        T& at(size_t index);
+        const T& at(size_t index) const;
+        void push_back(const T& elem);
+        void push_back(T&& elem);
+        template<typename... args>
+        void emplace_back(args&&... myArgs);
+        void pop_back();
+        void push_front(const T& elem);
+        void push_front(T&& elem);
+        template<typename... args>
+        void emplace_front(args&&... myArgs);
+        void pop_front();
+        void insert(const T& elem, size_t n);
+        void insert(T&& elem, size_t n);
+        void erase(size_t n);
+        void clear();
+        T& front();
+        const T& front() const;
+        T& back();
+        const T& back() const;
+        bool isEmpty() const;
+        void sort();
+        void swap(int a, int b);
+        Iterator begin() { return Iterator{this, 0}; }
+        Iterator end() { return Iterator{this, vecSize}; }
+        ConstIterator begin() const { return ConstIterator{this, 0}; }
+        ConstIterator end() const { return ConstIterator{this, vecSize}; }
+        template <typename U, size_t B>
+        friend std::ostream& operator<<(std::ostream& out, const SegmentedVector<U, B>& v);
+        ~SegmentedVector();
+};
+
+template<typename T, size_t BlockSize>
+T* SegmentedVector<T, BlockSize>::allocateBlock() {
+    if (spare) return std::exchange(spare, nullptr);
+    return allocateBuffer<T>(BlockSize, resource);
+}
+
+template<typename T, size_t BlockSize>
+void SegmentedVector<T, BlockSize>::freeBlock(T* block) {
+    if (!spare) spare = block;
+    else deallocateBuffer(block, BlockSize, resource);
+}
+
+// Re-centres the blocks in a directory twice as big, leaving room on the side that ran out
+template<typename T, size_t BlockSize>
+void SegmentedVector<T, BlockSize>::growDirectory(bool atFront) {
+    size_t newCapacity = std::max<size_t>(8, blockCount * 2 + 2);
+    T** newDirectory = allocateBuffer<T*>(newCapacity, resource);
+    size_t newFirst = (newCapacity - blockCount) / 2;
+    if (newFirst == 0 && atFront) newFirst = 1;
+
+    std::copy(directory + firstBlock, directory + firstBlock + blockCount, newDirectory + newFirst);
+    deallocateBuffer(directory, dirCapacity, resource);
+
+    directory = newDirectory;
+    dirCapacity = newCapacity;
+    firstBlock = newFirst;
+}
+
+template<typename T, size_t BlockSize>
+void SegmentedVector<T, BlockSize>::addBlockAtBack() {
+    if (firstBlock + blockCount == dirCapacity) growDirectory(false);
+    directory[firstBlock + blockCount] = allocateBlock();
+    ++blockCount;
+}
+
+template<typename T, size_t BlockSize>
+void SegmentedVector<T, BlockSize>::addBlockAtFront() {
+    if (firstBlock == 0) growDirectory(true);
+    directory[firstBlock - 1] = allocateBlock();
+    --firstBlock;
+    ++blockCount;
+    head += BlockSize;
+}
+
+template<typename T, size_t BlockSize>
+void SegmentedVector<T, BlockSize>::release() {
+    clear();
+    if (blockCount) deallocateBuffer(directory[firstBlock], BlockSize, resource); // clear() keeps one block
+    deallocateBuffer(spare, BlockSize, resource);
+    deallocateBuffer(directory, dirCapacity, resource);
+    directory = nullptr;
+    spare = nullptr;
+    dirCapacity = firstBlock = blockCount = head = 0;
+}
+
+template<typename T, size_t BlockSize>
+SegmentedVector<T, BlockSize>::SegmentedVector() : SegmentedVector{std::pmr::get_default_resource()} {}
+
+template<typename T, size_t BlockSize>
+SegmentedVector<T, BlockSize>::SegmentedVector(std::pmr::memory_resource* resource) :
+    directory{nullptr}, dirCapacity{0}, firstBlock{0}, blockCount{0}, head{0}, vecSize{0}, spare{nullptr}, resource{resource} {}
+
+template<typename T, size_t BlockSize>
+SegmentedVector<T, BlockSize>::SegmentedVector(const SegmentedVector& other) : SegmentedVector{other, std::pmr::get_default_resource()} {}
+
+template<typename T, size_t BlockSize>
+SegmentedVector<T, BlockSize>::SegmentedVector(const SegmentedVector& other, std::pmr::memory_resource* resource) :
+    SegmentedVector{resource} {
+        for (const T& elem : other) push_back(elem);
+    }
+
+template<typename T, size_t BlockSize>
+SegmentedVector<T, BlockSize>::SegmentedVector(SegmentedVector&& other) :
+    directory{other.directory}, dirCapacity{other.dirCapacity}, firstBlock{other.firstBlock}, blockCount{other.blockCount},
+    head{other.head}, vecSize{other.vecSize}, spare{other.spare}, resource{other.resource} {
+        other.directory = nullptr;
+        other.spare = nullptr;
+        other.dirCapacity = other.firstBlock = other.blockCount = other.head = other.vecSize = 0;
+    }
+
+template<typename T, size_t BlockSize>
+SegmentedVector<T, BlockSize>& SegmentedVector<T, BlockSize>::operator=(const SegmentedVector& other) {
+    if (this == &other) return *this;
+
+    clear(); // keeps our blocks around for the copy
+    for (const T& elem : other) push_back(elem);
+
+    return *this;
+}
+
+template<typename T, size_t BlockSize>
+SegmentedVector<T, BlockSize>& SegmentedVector<T, BlockSize>::operator=(SegmentedVector&& other) {
+    if (this == &other) return *this;
+
+    if (resource->is_equal(*other.resource)) { // steal the blocks
+        release();
+        std::swap(directory, other.directory);
+        std::swap(dirCapacity, other.dirCapacity);
+        std::swap(firstBlock, other.firstBlock);
+        std::swap(blockCount, other.blockCount);
+        std::swap(head, other.head);
+        std::swap(vecSize, other.vecSize);
+        std::swap(spare, other.spare);
+    } else { // can't free the other blocks through our resource, so move the elements over
+        clear();
+        for (T& elem : other) push_back(std::move(elem));
+        other.release();
+    }
+
+    return *this;
+}
+
+template<typename T, size_t BlockSize>
+size_t SegmentedVector<T, BlockSize>::size() const { return vecSize; }
+
+template<typename T, size_t BlockSize>
+std::pmr::memory_resource* SegmentedVector<T, BlockSize>::getResource() const { return resource; }
+
+template<typename T, size_t BlockSize>
+void SegmentedVector<T, BlockSize>::shrink_to_fit() {
+    if (vecSize == 0) { // includes the block clear() keeps
+        release();
+        return;
+    }
+
+    deallocateBuffer(spare, BlockSize, resource);
+    spare = nullptr;
+    if (dirCapacity > blockCount) { // exactly one slot per block; the next push at either end regrows it
+        T** trimmed = allocateBuffer<T*>(blockCount, resource);
+        std::copy(directory + firstBlock, directory + firstBlock + blockCount, trimmed);
+        deallocateBuffer(directory, dirCapacity, resource);
+        directory = trimmed;
+        dirCapacity = blockCount;
+        firstBlock = 0;
+    }
+}
+
+template<typename T, size_t BlockSize>
+T& SegmentedVector<T, BlockSize>::operator[](size_t index) {
+    size_t position = head + index;
+    return directory[firstBlock + position / BlockSize][position % BlockSize]; // BlockSize is a power of two: shift and mask
+}
+
+template<typename T, size_t BlockSize>
+const T& SegmentedVector<T, BlockSize>::operator[](size_t index) const {
+    size_t position = head + index;
+    return directory[firstBlock + position / BlockSize][position % BlockSize];
+}
+
+template<typename T, size_t BlockSize>
+T& SegmentedVector<T, BlockSize>::at(size_t index) {
+    if (index >= vecSize) throw std::out_of_range("Invalid index");
+    return (*this)[index];
+}
+
+template<typename T, size_t BlockSize>
+const T& SegmentedVector<T, BlockSize>::at(size_t index) const {
+    if (index >= vecSize) throw std::out_of_range("Invalid index");
+    return (*this)[index];
+}
+
+template<typename T, size_t BlockSize>
+void SegmentedVector<T, BlockSize>::push_back(const T& elem) {
+    emplace_back(elem);
+}
+
+template<typename T, size_t BlockSize>
+void SegmentedVector<T, BlockSize>::push_back(T&& elem) { // avoids unnecessary copies
+    emplace_back(std::move(elem));
+}
+
+template<typename T, size_t BlockSize>
+template<typename... args>
+void SegmentedVector<T, BlockSize>::emplace_back(args&&... myArgs) {
+    if (head + vecSize == blockCount * BlockSize) addBlockAtBack(); // existing elements never move
+    new(&(*this)[vecSize]) T(std::forward<args>(myArgs)...);
+    ++vecSize;
+}
+
+template<typename T, size_t BlockSize>
+void SegmentedVector<T, BlockSize>::pop_back() {
+    if (vecSize == 0) throw std::out_of_range("Empty array");
+    (*this)[vecSize - 1].~T();
+    --vecSize;
+
+    if (vecSize == 0) clear(); // back to a single block
+    else if (blockCount > 1 && head + vecSize <= (blockCount - 1) * BlockSize) { // last block emptied
+        freeBlock(directory[firstBlock + blockCount - 1]);
+        --blockCount;
+    }
+}
+
+template<typename T, size_t BlockSize>
+void SegmentedVector<T, BlockSize>::push_front(const T& elem) {
+    emplace_front(elem);
+}
+
+template<typename T, size_t BlockSize>
+void SegmentedVector<T, BlockSize>::push_front(T&& elem) {
+    emplace_front(std::move(elem));
+}
+
+template<typename T, size_t BlockSize>
+template<typename... args>
+void SegmentedVector<T, BlockSize>::emplace_front(args&&... myArgs) {
+    if (blockCount == 0) { // start at the end of the first block, so it fills towards the front
+        addBlockAtBack();
+        head = BlockSize;
+    } else if (head == 0) {
+        addBlockAtFront();
+    }
+
+    new(&directory[firstBlock + (head - 1) / BlockSize][(head - 1) % BlockSize]) T(std::forward<args>(myArgs)...);
+    --head;
+    ++vecSize;
+}
+
+template<typename T, size_t BlockSize>
+void SegmentedVector<T, BlockSize>::pop_front() {
+    if (vecSize == 0) throw std::out_of_range("Empty array");
+    (*this)[0].~T();
+    ++head;
+    --vecSize;
+
+    if (vecSize == 0) clear();
+    else if (blockCount > 1 && head == BlockSize) { // first block emptied
+        freeBlock(directory[firstBlock]);
+        ++firstBlock;
+        --blockCount;
+        head = 0;
+    }
+}
+
+template<typename T, size_t BlockSize>
+void SegmentedVector<T, BlockSize>::insert(const T& elem, size_t n) {
+    insert(T(elem), n);
+}
+
+template<typename T, size_t BlockSize>
+void SegmentedVector<T, BlockSize>::insert(T&& elem, size_t n) {
+    if (n > vecSize) {
+        throw std::out_of_range("Invalid index");
+    }
+
+    if (n < vecSize / 2) { // shift whichever side is shorter
+        emplace_front(std::move(elem));
+        for (size_t i = 0; i < n; ++i) std::swap((*this)[i], (*this)[i + 1]);
+    } else {
+        emplace_back(std::move(elem));
+        for (size_t i = vecSize - 1; i > n; --i) std::swap((*this)[i], (*this)[i - 1]);
+    }
+}
+
+template<typename T, size_t BlockSize>
+void SegmentedVector<T, BlockSize>::erase(size_t n) {
+    if (n >= vecSize) {
+        throw std::out_of_range("Invalid index");
+    }
+
+    if (n < vecSize / 2) {
+        for (size_t i = n; i > 0; --i) (*this)[i] = std::move((*this)[i - 1]);
+        pop_front();
+    } else {
+        for (size_t i = n; i + 1 < vecSize; ++i) (*this)[i] = std::move((*this)[i + 1]);
+        pop_back();
+    }
+}
+
+template<typename T, size_t BlockSize>
+void SegmentedVector<T, BlockSize>::clear() {
+    if constexpr (!std::is_trivially_destructible<T>::value) {
+        for (size_t i = 0; i < vecSize; ++i) (*this)[i].~T();
+    }
+    vecSize = 0;
+
+    while (blockCount > 1) { // keep one block so refilling doesn't allocate right away
+        freeBlock(directory[firstBlock + blockCount - 1]);
+        --blockCount;
+    }
+    head = 0;
+}
+
+template<typename T, size_t BlockSize>
+T& SegmentedVector<T, BlockSize>::front() {
+    if (vecSize == 0) throw std::out_of_range("Empty array");
+    return (*this)[0];
+}
+
+template<typename T, size_t BlockSize>
+const T& SegmentedVector<T, BlockSize>::front() const {
+    if (vecSize == 0) throw std::out_of_range("Empty array");
+    return (*this)[0];
+}
+
+template<typename T, size_t BlockSize>
+T& SegmentedVector<T, BlockSize>::back() {
+    if (vecSize == 0) throw std::out_of_range("Empty array");
+    return (*this)[vecSize - 1];
+}
+
+template<typename T, size_t BlockSize>
+const T& SegmentedVector<T, BlockSize>::back() const {
+    if (vecSize == 0) throw std::out_of_range("Empty array");
+    return (*this)[vecSize - 1];
+}
+
+template<typename T, size_t BlockSize>
+bool SegmentedVector<T, BlockSize>::isEmpty() const {
+    return vecSize == 0;
+}
+
+template<typename T, size_t BlockSize>
+void SegmentedVector<T, BlockSize>::sort() {
+    std::sort(begin(), end());
+}
+
+template<typename T, size_t BlockSize>
+void SegmentedVector<T, BlockSize>::swap(int a, int b) {
+    std::swap((*this)[a], (*this)[b]);
+}
+
+template<typename T, size_t BlockSize>
+std::ostream& operator<<(std::ostream& out, const SegmentedVector<T, BlockSize>& v) {
+    out << "{";
+    for (size_t i = 0; i < v.vecSize; ++i) {
+        out << v[i];
+        if (i != v.vecSize - 1) out << ", ";
+    }
+    out << "}" << std::endl;
+    return out;
+}
+
+template<typename T, size_t BlockSize>
+SegmentedVector<T, BlockSize>::~SegmentedVector() {
+    release();
+}
+
+// Tracks how many bytes are currently allocated through it
+class CountingResource : public std::pmr::memory_resource {
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            outstanding += bytes;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        void do_deallocate(void* memory, size_t bytes, size_t alignment) override {
+            outstanding -= bytes;
+            std::pmr::new_delete_resource()->deallocate(memory, bytes, alignment);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    public:
+        size_t outstanding = 0;
+};
+
+void testSegmentedVectorClass() {
+    SegmentedVector<std::string, 4> names; // tiny blocks so the test crosses block boundaries
+
+    names.push_back("Carlos");
+    names.push_back("Jonathan");
+    names.push_front("Amy");
+    names.emplace_back("Marcia");
+    names.emplace_front("Zoe");
+    names.push_back("Octavio");
+    std::cout << names;
+
+    std::string& amy = names[1];
+    for (int i = 0; i < 20; ++i) names.push_front("front" + std::to_string(i));
+    for (int i = 0; i < 20; ++i) names.push_back("back" + std::to_string(i));
+    LOG("Reference still valid: " << amy)
+
+    for (int i = 0; i < 20; ++i) names.pop_front();
+    for (int i = 0; i < 20; ++i) names.pop_back();
+    std::cout << names;
+
+    names.insert("Robert", 2);
+    names.erase(0);
+    names.swap(0, 1);
+    std::cout << names;
+    names.sort();
+    std::cout << names;
+    LOG("Front: " << names.front() << ", back: " << names.back() << ", at(2): " << names.at(2))
+
+    SegmentedVector<std::string, 4> copy{names};
+    copy.pop_front();
+    SegmentedVector<std::string, 4> moved{std::move(names)};
+    std::cout << copy << moved;
+
+    SegmentedVector<int> samples;
+    double worstMicros = 0;
+    for (int i = 0; i < 2000000; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        samples.push_back(i);
+        double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        worstMicros = std::max(worstMicros, micros);
+    }
+    LOG("Size: " << samples.size() << ", ordered: " << std::is_sorted(samples.begin(), samples.end()))
+    LOG("Worst push_back under 10ms: " << (worstMicros < 10000)) // never copies the elements already stored
+
+    samples.clear();
+    samples.shrink_to_fit();
+    LOG("Empty: " << samples.isEmpty())
+
+    CountingResource counting;
+    {
+        SegmentedVector<int, 16> readings{&counting};
+        for (int i = 0; i < 1000; ++i) readings.push_back(i);
+        while (readings.size() > 500) readings.pop_back(); // leaves a spare block and a roomy directory
+        readings.shrink_to_fit();
+        size_t blocks = (500 + 15) / 16;
+        LOG("Holds only its blocks and their pointers: " << (counting.outstanding == blocks * (16 * sizeof(int) + sizeof(int*))))
+
+        readings.clear();
+        readings.shrink_to_fit();
+        LOG("Holds nothing once empty: " << (counting.outstanding == 0))
+        readings.push_back(7); // and can still be refilled
+        LOG("Refilled: " << readings.front())
+    }
+    LOG("Everything returned: " << (counting.outstanding == 0))
+}
+
+int main() {
+    testSegmentedVectorClass();
+}
@@ -0,0 +1,345 @@
+// C++ Data Structures
+
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+/* SIMD Kernels
+- find/count/min/max/minmax/sum/dot over a contiguous buffer, written once with GCC/Clang vector
+  extensions and compiled for several widths: AVX-512 (64 bytes), AVX2 (32) and SSE4.2 (16)
+- The widest level the CPU supports is detected once at runtime, so one binary runs everywhere
+- Non-x86 builds, non-arithmetic types and bool use the plain scalar loops
+- Integer sums and dot products accumulate in 64 bits and floating-point ones in double, so
+  summing a large Vector<int> or Vector<char> doesn't overflow
+- Bit-packed sets get word-wise and/or/xor/andnot and a popcount that compiles to the hardware
+  POPCNT instruction inside each ISA's entry point
+*/
+
+// Widest float/integer type per lane, or T itself for non-arithmetic types
+template<typename T>
+using SumType = std::conditional_t<std::is_floating_point<T>::value, double,
+    std::conditional_t<std::is_integral<T>::value,
+        std::conditional_t<std::is_signed<T>::value, long long, unsigned long long>, T>>;
+
+template<typename T>
+constexpr bool isSimdType = std::is_arithmetic<T>::value && !std::is_same<T, bool>::value &&
+    sizeof(T) <= 8 && !std::is_same<T, long double>::value;
+
+// Scalar loops: the fallback, and the tail that doesn't fill a whole vector
+template<typename T>
+size_t scalarFind(const T* data, size_t from, size_t n, const T& value) {
+    for (size_t i = from; i < n; ++i)
+        if (data[i] == value) return i;
+    return n;
+}
+
+template<typename T>
+size_t scalarCount(const T* data, size_t from, size_t n, const T& value) {
+    size_t count = 0;
+    for (size_t i = from; i < n; ++i)
+        if (data[i] == value) ++count;
+    return count;
+}
+
+template<typename T>
+std::pair<T, T> scalarMinMax(const T* data, size_t from, size_t n, std::pair<T, T> result) {
+    for (size_t i = from; i < n; ++i) {
+        if (data[i] < result.first) result.first = data[i];
+        if (result.second < data[i]) result.second = data[i];
+    }
+    return result;
+}
+
+template<typename T>
+SumType<T> scalarSum(const T* data, size_t from, size_t n, SumType<T> sum) {
+    for (size_t i = from; i < n; ++i)
+        sum += (SumType<T>) data[i];
+    return sum;
+}
+
+template<typename T>
+SumType<T> scalarDot(const T* a, const T* b, size_t from, size_t n, SumType<T> sum) {
+    for (size_t i = from; i < n; ++i)
+        sum += (SumType<T>) a[i] * (SumType<T>) b[i];
+    return sum;
+}
+
+enum class BitOp { And, Or, Xor, AndNot };
+
+// Works on single words and on whole vectors of words alike; in place, like simdLoad, for the ABI
+template<BitOp Op, typename W>
+inline __attribute__((always_inline)) void applyBitOp(W& a, const W& b) {
+    if constexpr (Op == BitOp::And) a &= b;
+    if constexpr (Op == BitOp::Or) a |= b;
+    if constexpr (Op == BitOp::Xor) a ^= b;
+    if constexpr (Op == BitOp::AndNot) a &= ~b;
+}
+
+template<BitOp Op>
+void scalarBitwise(uint64_t* target, const uint64_t* source, size_t from, size_t n) {
+    for (size_t i = from; i < n; ++i)
+        applyBitOp<Op>(target[i], source[i]);
+}
+
+inline size_t scalarPopcount(const uint64_t* words, size_t from, size_t n) {
+    size_t count = 0;
+    for (size_t i = from; i < n; ++i)
+        count += (size_t) __builtin_popcountll(words[i]);
+    return count;
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_KERNELS_X86 1
+#define SIMD_INLINE inline __attribute__((always_inline)) // so kernels pick up the caller's target ISA
+
+enum class SimdLevel { Scalar, SSE42, AVX2, AVX512 };
+
+inline SimdLevel detectSimdLevel() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse4.2")) return SimdLevel::SSE42;
+    return SimdLevel::Scalar;
+}
+
+inline SimdLevel simdLevel() {
+    static const SimdLevel level = detectSimdLevel();
+    return level;
+}
+
+template<typename T, size_t Bytes>
+struct SimdVec {
+    typedef T type __attribute__((vector_size(Bytes)));
+};
+
+// Unaligned load; takes an out-parameter because returning a vector type by value is an ABI hazard
+template<typename Vec, typename T>
+SIMD_INLINE void simdLoad(Vec& v, const T* memory) {
+    std::memcpy(&v, memory, sizeof(Vec));
+}
+
+template<typename T>
+struct FindKernel {
+    template<size_t Bytes>
+    static SIMD_INLINE size_t run(const T* data, size_t n, T value) {
+        constexpr size_t lanes = Bytes / sizeof(T);
+        typename SimdVec<T, Bytes>::type block;
+        size_t i = 0;
+        for (; i + lanes <= n; i += lanes) {
+            simdLoad(block, data + i);
+            auto matches = block == value;
+            for (size_t lane = 0; lane < lanes; ++lane)
+                if (matches[lane]) return i + lane;
+        }
+        return scalarFind(data, i, n, value);
+    }
+};
+
+template<typename T>
+struct CountKernel {
+    template<size_t Bytes>
+    static SIMD_INLINE size_t run(const T* data, size_t n, T value) {
+        constexpr size_t lanes = Bytes / sizeof(T);
+        typename SimdVec<T, Bytes>::type block;
+        typedef decltype(block == value) Mask; // lanes are 0 or -1
+        typedef std::remove_reference_t<decltype(Mask{}[0])> MaskLane;
+        constexpr size_t flushEvery = (size_t) std::numeric_limits<MaskLane>::max(); // before narrow lanes overflow
+
+        size_t count = 0;
+        size_t i = 0;
+        while (i + lanes <= n) {
+            Mask laneCounts = Mask{};
+            for (size_t blocks = 0; blocks < flushEvery && i + lanes <= n; ++blocks, i += lanes) {
+                simdLoad(block, data + i);
+                laneCounts -= block == value;
+            }
+            for (size_t lane = 0; lane < lanes; ++lane)
+                count += (size_t) laneCounts[lane];
+        }
+        return count + scalarCount(data, i, n, value);
+    }
+};
+
+template<typename T>
+struct MinMaxKernel {
+    template<size_t Bytes>
+    static SIMD_INLINE std::pair<T, T> run(const T* data, size_t n) {
+        constexpr size_t lanes = Bytes / sizeof(T);
+        std::pair<T, T> result{data[0], data[0]};
+        if (n < lanes) return scalarMinMax(data, 1, n, result);
+
+        typename SimdVec<T, Bytes>::type block, low, high;
+        simdLoad(low, data);
+        high = low;
+        size_t i = lanes;
+        for (; i + lanes <= n; i += lanes) {
+            simdLoad(block, data + i);
+            low = block < low ? block : low;
+            high = high < block ? block : high;
+        }
+
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            if (low[lane] < result.first) result.first = low[lane];
+            if (result.second < high[lane]) result.second = high[lane];
+        }
+        return scalarMinMax(data, i, n, result);
+    }
+};
+
+template<typename T>
+struct SumKernel {
+    template<size_t Bytes>
+    static SIMD_INLINE SumType<T> run(const T* data, size_t n) {
+        constexpr size_t lanes = Bytes / sizeof(T);
+        typedef typename SimdVec<SumType<T>, lanes * sizeof(SumType<T>)>::type Wide;
+
+        typename SimdVec<T, Bytes>::type block;
+        Wide sums = Wide{};
+        size_t i = 0;
+        for (; i + lanes <= n; i += lanes) {
+            simdLoad(block, data + i);
+            sums += __builtin_convertvector(block, Wide);
+        }
+
+        SumType<T> sum = 0;
+        for (size_t lane = 0; lane < lanes; ++lane) sum += sums[lane];
+        return scalarSum(data, i, n, sum);
+    }
+};
+
+template<typename T>
+struct DotKernel {
+    template<size_t Bytes>
+    static SIMD_INLINE SumType<T> run(const T* a, const T* b, size_t n) {
+        constexpr size_t lanes = Bytes / sizeof(T);
+        typedef typename SimdVec<SumType<T>, lanes * sizeof(SumType<T>)>::type Wide;
+
+        typename SimdVec<T, Bytes>::type blockA, blockB;
+        Wide sums = Wide{};
+        size_t i = 0;
+        for (; i + lanes <= n; i += lanes) {
+            simdLoad(blockA, a + i);
+            simdLoad(blockB, b + i);
+            sums += __builtin_convertvector(blockA, Wide) * __builtin_convertvector(blockB, Wide);
+        }
+
+        SumType<T> sum = 0;
+        for (size_t lane = 0; lane < lanes; ++lane) sum += sums[lane];
+        return scalarDot(a, b, i, n, sum);
+    }
+};
+
+template<BitOp Op>
+struct BitwiseKernel {
+    template<size_t Bytes>
+    static SIMD_INLINE void run(uint64_t* target, const uint64_t* source, size_t n) {
+        constexpr size_t lanes = Bytes / sizeof(uint64_t);
+        typename SimdVec<uint64_t, Bytes>::type a, b;
+        size_t i = 0;
+        for (; i + lanes <= n; i += lanes) {
+            simdLoad(a, target + i);
+            simdLoad(b, source + i);
+            applyBitOp<Op>(a, b);
+            std::memcpy(target + i, &a, sizeof(a));
+        }
+        scalarBitwise<Op>(target, source, i, n);
+    }
+};
+
+struct PopcountKernel {
+    template<size_t Bytes>
+    static SIMD_INLINE size_t run(const uint64_t* words, size_t n) {
+        size_t counts[4] = {0, 0, 0, 0}; // independent chains, so several POPCNTs are in flight at once
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+            for (size_t k = 0; k < 4; ++k) counts[k] += (size_t) __builtin_popcountll(words[i + k]);
+        return counts[0] + counts[1] + counts[2] + counts[3] + scalarPopcount(words, i, n);
+    }
+};
+
+// One entry point per instruction set; the kernel is inlined into each and compiled for that ISA
+template<typename Kernel, typename... Args>
+__attribute__((target("avx512f,avx512bw"))) auto runAVX512(Args... args) { return Kernel::template run<64>(args...); }
+
+template<typename Kernel, typename... Args>
+__attribute__((target("avx2"))) auto runAVX2(Args... args) { return Kernel::template run<32>(args...); }
+
+template<typename Kernel, typename... Args>
+__attribute__((target("sse4.2"))) auto runSSE42(Args... args) { return Kernel::template run<16>(args...); }
+#endif
+
+// Runs [Kernel] at the widest level the CPU supports, or [fallback] if there is none
+template<typename T, typename Kernel, typename Fallback, typename... Args>
+auto simdDispatch(Fallback fallback, Args... args) {
+#if SIMD_KERNELS_X86
+    if constexpr (isSimdType<T>) {
+        switch (simdLevel()) {
+            case SimdLevel::AVX512: return runAVX512<Kernel>(args...);
+            case SimdLevel::AVX2: return runAVX2<Kernel>(args...);
+            case SimdLevel::SSE42: return runSSE42<Kernel>(args...);
+            case SimdLevel::Scalar: break;
+        }
+    }
+#endif
+    return fallback(args...);
+}
+
+// Index of the first element equal to [value], or [n] if there is none
+template<typename T>
+size_t simdFind(const T* data, size_t n, const T& value) {
+    return simdDispatch<T, FindKernel<T>>([](const T* data, size_t n, const T& value) {
+        return scalarFind(data, 0, n, value);
+    }, data, n, value);
+}
+
+template<typename T>
+size_t simdCount(const T* data, size_t n, const T& value) {
+    return simdDispatch<T, CountKernel<T>>([](const T* data, size_t n, const T& value) {
+        return scalarCount(data, 0, n, value);
+    }, data, n, value);
+}
+
+// [n] must be at least 1
+template<typename T>
+std::pair<T, T> simdMinMax(const T* data, size_t n) {
+    return simdDispatch<T, MinMaxKernel<T>>([](const T* data, size_t n) {
+        return scalarMinMax(data, 1, n, std::pair<T, T>{data[0], data[0]});
+    }, data, n);
+}
+
+template<typename T>
+SumType<T> simdSum(const T* data, size_t n) {
+    return simdDispatch<T, SumKernel<T>>([](const T* data, size_t n) {
+        return scalarSum(data, 0, n, SumType<T>{});
+    }, data, n);
+}
+
+template<typename T>
+SumType<T> simdDot(const T* a, const T* b, size_t n) {
+    return simdDispatch<T, DotKernel<T>>([](const T* a, const T* b, size_t n) {
+        return scalarDot(a, b, 0, n, SumType<T>{});
+    }, a, b, n);
+}
+
+// target[i] = target[i] Op source[i] for each of the [n] words
+template<BitOp Op>
+void simdBitwise(uint64_t* target, const uint64_t* source, size_t n) {
+    simdDispatch<uint64_t, BitwiseKernel<Op>>([](uint64_t* target, const uint64_t* source, size_t n) {
+        scalarBitwise<Op>(target, source, 0, n);
+    }, target, source, n);
+}
+
+// Number of set bits in [n] words
+inline size_t simdPopcount(const uint64_t* words, size_t n) {
+    return simdDispatch<uint64_t, PopcountKernel>([](const uint64_t* words, size_t n) {
+        return scalarPopcount(words, 0, n);
+    }, words, n);
+}
+
+#endif
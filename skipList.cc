@@ -8,7 +8,15 @@
 #endif
 
 #include <iostream>
+#include <cstdlib>
+#include <algorithm>
 #include <deque>
+#include <limits>
+#include <memory_resource>
+#include <type_traits>
+
+#include "nodeAllocation.h"
+#include "nodePool.h"
 
 template<typename K, typename V>
 class SkipList {
@@ -19,6 +27,8 @@ class SkipList {
         SLNode* below;
     };
 
+    std::pmr::memory_resource* resource; // supplies the pool's slabs
+    NodePool nodePool; // nodes, keys and values all come from here
     SLNode* startingSentinel;
     int kvPairCount;
     int levels;
@@ -29,12 +39,15 @@ class SkipList {
         void getPredecessors(const K& key) const;
         void deleteSLNode(SLNode* node);
         void clear();
+        NodePool makeNodePool() const;
     public:
         SkipList();
+        explicit SkipList(std::pmr::memory_resource* resource); // e.g. a per-request arena or a pool
         SkipList(const SkipList& other);
         SkipList(SkipList&& other);
         SkipList& operator=(const SkipList& other);
         SkipList& operator=(SkipList&& other);
+        std::pmr::memory_resource* getResource() const;
         constexpr int height() const;
         constexpr int count() const;
         void insert(const K& key, const V& value);
@@ -65,53 +78,67 @@ void SkipList<K, V>::getPredecessors(const K& key) const {
 template<typename K, typename V>
 void SkipList<K, V>::deleteSLNode(SLNode* node) {
     if (!node->below) {
-        delete node->key;
-        if (node->value) delete node->value;
+        destroyNode(&nodePool, node->key);
+        if (node->value) destroyNode(&nodePool, node->value);
     }
-    delete node;
+    destroyNode(&nodePool, node);
 }
 
 template<typename K, typename V>
 void SkipList<K, V>::clear() {
-    SLNode* listTraverser = startingSentinel;
-    SLNode* nodeTraverser = nullptr;
-    SLNode* toBeDeleted = nullptr;
-    while (listTraverser) {
-        nodeTraverser = listTraverser;
-        listTraverser = listTraverser->below;
-        while (nodeTraverser) {
-            toBeDeleted = nodeTraverser;
-            nodeTraverser = nodeTraverser->next;
-            deleteSLNode(toBeDeleted);
+    if constexpr (!std::is_trivially_destructible<K>::value || !std::is_trivially_destructible<V>::value) {
+        SLNode* bottom = startingSentinel;
+        while (bottom && bottom->below) bottom = bottom->below;
+
+        // only the bottom level owns its key and value; the levels above share them
+        for (SLNode* node = bottom; node; node = node->next) {
+            node->key->~K();
+            if (node->value) node->value->~V();
         }
     }
+
+    nodePool.release(); // hands back whole slabs instead of freeing node by node
+    startingSentinel = nullptr;
 }
 
+// One block size fits all three kinds of allocation
 template<typename K, typename V>
-SkipList<K, V>::SkipList() : startingSentinel{nullptr}, kvPairCount{0}, levels{0} {
-    startingSentinel = new SLNode{
-        new K{std::numeric_limits<K>::min()},
-        nullptr, nullptr, nullptr
+NodePool SkipList<K, V>::makeNodePool() const {
+    return NodePool{
+        std::max({sizeof(SLNode), sizeof(K), sizeof(V)}),
+        std::max({alignof(SLNode), alignof(K), alignof(V)}),
+        resource
     };
 }
 
 template<typename K, typename V>
-SkipList<K, V>::SkipList(const SkipList& other) : startingSentinel{nullptr}, kvPairCount{other.kvPairCount}, levels{other.levels} {
+SkipList<K, V>::SkipList() : SkipList{std::pmr::get_default_resource()} {}
+
+template<typename K, typename V>
+SkipList<K, V>::SkipList(std::pmr::memory_resource* resource) : resource{resource}, nodePool{makeNodePool()}, startingSentinel{nullptr}, kvPairCount{0}, levels{0} {
+    startingSentinel = createNode<SLNode>(&nodePool,
+        createNode<K>(&nodePool, std::numeric_limits<K>::min()),
+        nullptr, nullptr, nullptr
+    );
+}
+
+template<typename K, typename V>
+SkipList<K, V>::SkipList(const SkipList& other) : resource{std::pmr::get_default_resource()}, nodePool{makeNodePool()}, startingSentinel{nullptr}, kvPairCount{other.kvPairCount}, levels{other.levels} {
     SLNode* otherTraverser = other.startingSentinel;
     SLNode* tempNode = nullptr;
-    SLNode* currTraverser = new SLNode{
-        new K{std::numeric_limits<K>::min()},
+    SLNode* currTraverser = createNode<SLNode>(&nodePool,
+        createNode<K>(&nodePool, std::numeric_limits<K>::min()),
         nullptr, nullptr, nullptr
-    };
+    );
     startingSentinel = currTraverser;
 
     for (int i = 0; i < levels; ++i) {
         tempNode = startingSentinel;
-        startingSentinel = new SLNode{
+        startingSentinel = createNode<SLNode>(&nodePool,
             tempNode->key,
             nullptr, nullptr,
             tempNode
-        };
+        );
     }
 
     while (otherTraverser->below) otherTraverser = otherTraverser->below;
@@ -127,12 +154,12 @@ SkipList<K, V>::SkipList(const SkipList& other) : startingSentinel{nullptr}, kvP
         other.predecessorStack.pop_front();
         predecessorStack.pop_front();
 
-        currTraverser->next = new SLNode{
-            new K{*(otherTraverser->key)},
-            new V{*(otherTraverser->value)},
+        currTraverser->next = createNode<SLNode>(&nodePool,
+            createNode<K>(&nodePool, *(otherTraverser->key)),
+            createNode<V>(&nodePool, *(otherTraverser->value)),
             nullptr,
             nullptr
-        };
+        );
         currTraverser = currTraverser->next;
         SLNode* bottomNode = currTraverser;
 
@@ -145,12 +172,12 @@ SkipList<K, V>::SkipList(const SkipList& other) : startingSentinel{nullptr}, kvP
             LOG(*(thisNode->key))
 
             if (otherNode->next && *(otherNode->next->key) == *(otherTraverser->key)) {
-                thisNode->next = new SLNode{
+                thisNode->next = createNode<SLNode>(&nodePool,
                     currTraverser->key,
                     nullptr,
                     nullptr,
                     bottomNode
-                };
+                );
                 bottomNode = thisNode;
             } else {
                 break;
@@ -160,7 +187,7 @@ SkipList<K, V>::SkipList(const SkipList& other) : startingSentinel{nullptr}, kvP
 }
 
 template<typename K, typename V>
-SkipList<K, V>::SkipList(SkipList&& other) : startingSentinel{other.startingSentinel}, kvPairCount{other.kvPairCount}, levels{other.levels} {
+SkipList<K, V>::SkipList(SkipList&& other) : resource{other.resource}, nodePool{std::move(other.nodePool)}, startingSentinel{other.startingSentinel}, kvPairCount{other.kvPairCount}, levels{other.levels} {
     other.startingSentinel = nullptr;
 }
 
@@ -173,19 +200,19 @@ SkipList<K, V>& SkipList<K, V>::operator=(const SkipList& other) {
 
     SLNode* otherTraverser = other.startingSentinel;
     SLNode* tempNode = nullptr;
-    SLNode* currTraverser = new SLNode{
-        new K{std::numeric_limits<K>::min()},
+    SLNode* currTraverser = createNode<SLNode>(&nodePool,
+        createNode<K>(&nodePool, std::numeric_limits<K>::min()),
         nullptr, nullptr, nullptr
-    };
+    );
     startingSentinel = currTraverser;
 
     for (int i = 0; i < levels; ++i) {
         tempNode = startingSentinel;
-        startingSentinel = new SLNode{
+        startingSentinel = createNode<SLNode>(&nodePool,
             tempNode->key,
             nullptr, nullptr,
             tempNode
-        };
+        );
     }
 
     while (otherTraverser->below) otherTraverser = otherTraverser->below;
@@ -201,12 +228,12 @@ SkipList<K, V>& SkipList<K, V>::operator=(const SkipList& other) {
         other.predecessorStack.pop_front();
         predecessorStack.pop_front();
 
-        currTraverser->next = new SLNode{
-            new K{*(otherTraverser->key)},
-            new V{*(otherTraverser->value)},
+        currTraverser->next = createNode<SLNode>(&nodePool,
+            createNode<K>(&nodePool, *(otherTraverser->key)),
+            createNode<V>(&nodePool, *(otherTraverser->value)),
             nullptr,
             nullptr
-        };
+        );
         currTraverser = currTraverser->next;
         SLNode* bottomNode = currTraverser;
 
@@ -217,12 +244,12 @@ SkipList<K, V>& SkipList<K, V>::operator=(const SkipList& other) {
             predecessorStack.pop_front();
 
             if (otherNode->next && *(otherNode->next->key) == *(otherTraverser->key)) {
-                thisNode->next = new SLNode{
+                thisNode->next = createNode<SLNode>(&nodePool,
                     currTraverser->key,
                     nullptr,
                     nullptr,
                     bottomNode
-                };
+                );
                 bottomNode = thisNode;
             } else {
                 break;
@@ -238,10 +265,15 @@ SkipList<K, V>& SkipList<K, V>::operator=(SkipList&& other) {
     std::swap(startingSentinel, other.startingSentinel);
     std::swap(kvPairCount, other.kvPairCount);
     std::swap(levels, other.levels);
+    std::swap(resource, other.resource);
+    nodePool.swap(other.nodePool); // the nodes must go back to the pool they came from
 
     return *this;
 }
 
+template<typename K, typename V>
+std::pmr::memory_resource* SkipList<K, V>::getResource() const { return resource; }
+
 template<typename K, typename V>
 constexpr int SkipList<K, V>::height() const { return levels; }
 
@@ -259,11 +291,11 @@ void SkipList<K, V>::insert(const K& key, const V& value) {
 
     SLNode* item = nullptr;
     while (i >= predecessorStack.size()) {
-        item = new SLNode{
+        item = createNode<SLNode>(&nodePool,
             startingSentinel->key,
             nullptr, nullptr,
             startingSentinel
-        };
+        );
         startingSentinel = item;
 
         predecessorStack.push_back(item);
@@ -274,12 +306,12 @@ void SkipList<K, V>::insert(const K& key, const V& value) {
     SLNode* bottomItem = predecessorStack.front();
     predecessorStack.pop_front();
 
-    SLNode* bottomNext = new SLNode{
-        new K{key},
-        new V{value},
+    SLNode* bottomNext = createNode<SLNode>(&nodePool,
+        createNode<K>(&nodePool, key),
+        createNode<V>(&nodePool, value),
         bottomItem->next,
         nullptr
-    };
+    );
     bottomItem->next = bottomNext;
 
     SLNode* beingAdded = nullptr;
@@ -287,12 +319,12 @@ void SkipList<K, V>::insert(const K& key, const V& value) {
         SLNode* bottomItem = predecessorStack.front();
         predecessorStack.pop_front();
 
-        beingAdded = new SLNode{
+        beingAdded = createNode<SLNode>(&nodePool,
             bottomNext->key,
             bottomNext->value,
             bottomItem->next,
             bottomNext
-        };
+        );
         bottomItem->next = beingAdded;
         bottomNext = beingAdded;
 
@@ -326,7 +358,7 @@ void SkipList<K, V>::remove(const K& key) {
     while (root->below && !root->below->next) {
         toBeDeleted = root->below;
         root->below = root->below->below;
-        delete toBeDeleted;
+        destroyNode(&nodePool, toBeDeleted);
         --levels;
     }
 }
@@ -442,6 +474,11 @@ void testSkipList() {
     celtics = getSkipList<int, std::string>();
     std::cout << celtics << std::endl;
 
+    std::pmr::unsynchronized_pool_resource nodePool;
+    SkipList<int, std::string> pooledRoster{&nodePool};
+    pooledRoster.insert(2, "Kawhi");
+    pooledRoster.insert(24, "Kobe");
+    std::cout << pooledRoster << std::endl;
 }
 
 int main() {
@@ -0,0 +1,485 @@
+// C++ Data Structures
+
+#define DEBUG_MODE 1
+#if DEBUG_MODE
+#define LOG(x) std::cout << x << std::endl;
+#else
+#define LOG(x)
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "growthPolicy.h"
+#include "relocate.h"
+#include "span.h"
+
+/* SoAVector
+- A Vector of rows stored as a structure of arrays: every field lives in its own contiguous
+  column, so a loop over one or two fields only pulls those fields through the cache
+- Columns are cache-line aligned and grow together, using the same growth policies and
+  relocation helpers as Vector
+- column<I>() hands out a flat view of one field for scans; operator[] returns a row proxy (a
+  tuple of references) for code written against whole records
+*/
+
+constexpr size_t columnAlignment = 64;
+
+// A contiguous run of one field's values
+template<typename T>
+using ColumnSpan = Span<T>;
+
+template<typename Growth, typename... Fields>
+class BasicSoAVector {
+    static_assert(sizeof...(Fields) > 0, "SoAVector needs at least one field");
+
+    template<size_t I>
+    using Field = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+    std::tuple<Fields*...> columns;
+    size_t vecSize;
+    size_t vecCapacity;
+    std::pmr::memory_resource* resource;
+
+        static constexpr size_t alignmentOf(size_t fieldAlignment) { return std::max(fieldAlignment, columnAlignment); }
+
+        template<typename F, size_t... I>
+        static void forEachIndex(F f, std::index_sequence<I...>) { (f(std::integral_constant<size_t, I>{}), ...); }
+        template<typename F>
+        static void forEachColumn(F f) { forEachIndex(f, std::index_sequence_for<Fields...>{}); }
+
+        template<size_t I = 0, typename Values>
+        void constructRow(size_t row, Values&& values);
+        void reallocateMemory(size_t newCap);
+        void grow(size_t required);
+        void destroyRows(size_t from, size_t to);
+        void release();
+    public:
+        typedef std::tuple<Fields&...> Row; // row proxy: assigning to it writes through to the columns
+        typedef std::tuple<const Fields&...> ConstRow;
+
+        BasicSoAVector();
+        explicit BasicSoAVector(std::pmr::memory_resource* resource);
+        BasicSoAVector(const BasicSoAVector& other);
+        BasicSoAVector(const BasicSoAVector& other, std::pmr::memory_resource* resource);
+        BasicSoAVector(BasicSoAVector&& other);
+        BasicSoAVector& operator=(const BasicSoAVector& other);
+        BasicSoAVector& operator=(BasicSoAVector&& other);
+        size_t size() const;
+        size_t capacity() const;
+        std::pmr::memory_resource* getResource() const;
+        void reserve(size_t newCap);
+        void shrink_to_fit();
+        void resize(size_t newSize);
+        template<size_t I>
+        ColumnSpan<Field<I>> column();
+        template<size_t I>
+        ColumnSpan<const Field<I>> column() const;
+        Row operator[](size_t index);
+        ConstRow operator[](size_t index) const;
+        Row at(size_t index);
+        ConstRow at(size_t index) const;
+        Row front();
+        Row back();
+        void push_back(const Fields&... fields);
+        void push_back(Fields&&... fields);
+        template<typename... args>
+        void emplace_back(args&&... myArgs); // one constructor argument per field
+        void pop_back();
+        void erase(size_t n);
+        void clear();
+        bool isEmpty() const;
+        void swap(size_t a, size_t b);
+
+        class Iterator { // walks rows, yielding row proxies
+            BasicSoAVector* v;
+            size_t index;
+            public:
+                Iterator(BasicSoAVector* v, size_t index) : v{v}, index{index} {}
+                Row operator*() const { return (*v)[index]; }
+                Iterator& operator++() { ++index; return *this; }
+                bool operator==(const Iterator& other) const { return index == other.index; }
+                bool operator!=(const Iterator& other) const { return index != other.index; }
+        };
+        Iterator begin() { return Iterator{this, 0}; }
+        Iterator end() { return Iterator{this, vecSize}; }
+
+        template <typename G, typename... F>
+        friend std::ostream& operator<<(std::ostream& out, const BasicSoAVector<G, F...>& v);
+        ~BasicSoAVector();
+};
+
+template<typename... Fields>
+using SoAVector = BasicSoAVector<DoublingGrowth, Fields...>;
+
+template<typename Growth, typename... Fields>
+template<size_t I, typename Values>
+void BasicSoAVector<Growth, Fields...>::constructRow(size_t row, Values&& values) {
+    if constexpr (I < sizeof...(Fields)) {
+        Field<I>* column = std::get<I>(columns);
+        new(&column[row]) Field<I>(std::get<I>(std::forward<Values>(values)));
+        try {
+            constructRow<I + 1>(row, std::forward<Values>(values));
+        } catch (...) { // a later field threw: undo this one so the row is all or nothing
+            column[row].~Field<I>();
+            throw;
+        }
+    }
+}
+
+template<typename Growth, typename... Fields>
+void BasicSoAVector<Growth, Fields...>::reallocateMemory(size_t newCap) {
+    // Every new column is allocated before any is touched, so a failed allocation leaves the rows as they were
+    std::tuple<Fields*...> resized{};
+    try {
+        forEachColumn([&](auto I) {
+            typedef Field<decltype(I)::value> T;
+            std::get<decltype(I)::value>(resized) = allocateBuffer<T>(newCap, resource, alignmentOf(alignof(T)));
+        });
+    } catch (...) {
+        forEachColumn([&](auto I) {
+            typedef Field<decltype(I)::value> T;
+            deallocateBuffer(std::get<decltype(I)::value>(resized), newCap, resource, alignmentOf(alignof(T))); // null if never allocated
+        });
+        throw;
+    }
+
+    if (newCap < vecSize) {
+        destroyRows(newCap, vecSize);
+        vecSize = newCap;
+    }
+
+    forEachColumn([&](auto I) {
+        typedef Field<decltype(I)::value> T;
+        T*& column = std::get<decltype(I)::value>(columns);
+        T* fresh = std::get<decltype(I)::value>(resized);
+
+        relocateRange(column, vecSize, fresh); // memcpy for trivially copyable fields
+        deallocateBuffer(column, vecCapacity, resource, alignmentOf(alignof(T)));
+        column = fresh;
+    });
+    vecCapacity = newCap;
+}
+
+template<typename Growth, typename... Fields>
+void BasicSoAVector<Growth, Fields...>::grow(size_t required) {
+    reallocateMemory(Growth::grow(vecCapacity, required, (sizeof(Fields) + ...)));
+}
+
+template<typename Growth, typename... Fields>
+void BasicSoAVector<Growth, Fields...>::destroyRows(size_t from, size_t to) {
+    forEachColumn([&](auto I) { destroyRange(std::get<decltype(I)::value>(columns) + from, to - from); });
+}
+
+template<typename Growth, typename... Fields>
+void BasicSoAVector<Growth, Fields...>::release() {
+    destroyRows(0, vecSize);
+    forEachColumn([&](auto I) {
+        typedef Field<decltype(I)::value> T;
+        T*& column = std::get<decltype(I)::value>(columns);
+        deallocateBuffer(column, vecCapacity, resource, alignmentOf(alignof(T)));
+        column = nullptr;
+    });
+    vecSize = 0;
+    vecCapacity = 0;
+}
+
+template<typename Growth, typename... Fields>
+BasicSoAVector<Growth, Fields...>::BasicSoAVector() : BasicSoAVector{heapResource()} {}
+
+template<typename Growth, typename... Fields>
+BasicSoAVector<Growth, Fields...>::BasicSoAVector(std::pmr::memory_resource* resource) :
+    columns{}, vecSize{0}, vecCapacity{0}, resource{resource} {}
+
+template<typename Growth, typename... Fields>
+BasicSoAVector<Growth, Fields...>::BasicSoAVector(const BasicSoAVector& other) : BasicSoAVector{other, heapResource()} {}
+
+template<typename Growth, typename... Fields>
+BasicSoAVector<Growth, Fields...>::BasicSoAVector(const BasicSoAVector& other, std::pmr::memory_resource* resource) :
+    BasicSoAVector{resource} {
+        *this = other;
+    }
+
+template<typename Growth, typename... Fields>
+BasicSoAVector<Growth, Fields...>::BasicSoAVector(BasicSoAVector&& other) :
+    columns{other.columns}, vecSize{other.vecSize}, vecCapacity{other.vecCapacity}, resource{other.resource} {
+        other.columns = {};
+        other.vecSize = 0;
+        other.vecCapacity = 0;
+    }
+
+template<typename Growth, typename... Fields>
+BasicSoAVector<Growth, Fields...>& BasicSoAVector<Growth, Fields...>::operator=(const BasicSoAVector& other) {
+    if (this == &other) return *this;
+
+    destroyRows(0, vecSize);
+    vecSize = 0;
+    if (vecCapacity < other.vecSize) reallocateMemory(other.vecSize); // reuse the columns when they're big enough
+
+    forEachColumn([&](auto I) {
+        constexpr size_t i = decltype(I)::value;
+        uninitializedCopy(std::get<i>(other.columns), other.vecSize, std::get<i>(columns));
+    });
+    vecSize = other.vecSize;
+
+    return *this;
+}
+
+template<typename Growth, typename... Fields>
+BasicSoAVector<Growth, Fields...>& BasicSoAVector<Growth, Fields...>::operator=(BasicSoAVector&& other) {
+    if (this == &other) return *this;
+
+    if (resource->is_equal(*other.resource)) { // steal the columns
+        release();
+        std::swap(columns, other.columns);
+        std::swap(vecSize, other.vecSize);
+        std::swap(vecCapacity, other.vecCapacity);
+    } else { // can't free the other columns through our resource, so copy out of them
+        *this = static_cast<const BasicSoAVector&>(other);
+        other.release();
+    }
+
+    return *this;
+}
+
+template<typename Growth, typename... Fields>
+size_t BasicSoAVector<Growth, Fields...>::size() const { return vecSize; }
+
+template<typename Growth, typename... Fields>
+size_t BasicSoAVector<Growth, Fields...>::capacity() const { return vecCapacity; }
+
+template<typename Growth, typename... Fields>
+std::pmr::memory_resource* BasicSoAVector<Growth, Fields...>::getResource() const { return resource; }
+
+template<typename Growth, typename... Fields>
+void BasicSoAVector<Growth, Fields...>::reserve(size_t newCap) {
+    if (newCap > vecCapacity) reallocateMemory(newCap);
+}
+
+template<typename Growth, typename... Fields>
+void BasicSoAVector<Growth, Fields...>::shrink_to_fit() {
+    if (vecCapacity > vecSize) reallocateMemory(vecSize);
+}
+
+template<typename Growth, typename... Fields>
+void BasicSoAVector<Growth, Fields...>::resize(size_t newSize) {
+    if (newSize < vecSize) {
+        destroyRows(newSize, vecSize);
+        vecSize = newSize;
+        return;
+    }
+
+    if (newSize > vecCapacity) reallocateMemory(newSize);
+    while (vecSize < newSize) emplace_back(Fields{}...);
+}
+
+template<typename Growth, typename... Fields>
+template<size_t I>
+ColumnSpan<typename BasicSoAVector<Growth, Fields...>::template Field<I>> BasicSoAVector<Growth, Fields...>::column() {
+    return {std::get<I>(columns), vecSize};
+}
+
+template<typename Growth, typename... Fields>
+template<size_t I>
+ColumnSpan<const typename BasicSoAVector<Growth, Fields...>::template Field<I>> BasicSoAVector<Growth, Fields...>::column() const {
+    return {std::get<I>(columns), vecSize};
+}
+
+template<typename Growth, typename... Fields>
+typename BasicSoAVector<Growth, Fields...>::Row BasicSoAVector<Growth, Fields...>::operator[](size_t index) {
+    return std::apply([index](Fields*... column) { return Row{column[index]...}; }, columns);
+}
+
+template<typename Growth, typename... Fields>
+typename BasicSoAVector<Growth, Fields...>::ConstRow BasicSoAVector<Growth, Fields...>::operator[](size_t index) const {
+    return std::apply([index](Fields*... column) { return ConstRow{column[index]...}; }, columns);
+}
+
+template<typename Growth, typename... Fields>
+typename BasicSoAVector<Growth, Fields...>::Row BasicSoAVector<Growth, Fields...>::at(size_t index) {
+    if (index >= vecSize) throw std::out_of_range("Invalid index");
+    return (*this)[index];
+}
+
+template<typename Growth, typename... Fields>
+typename BasicSoAVector<Growth, Fields...>::ConstRow BasicSoAVector<Growth, Fields...>::at(size_t index) const {
+    if (index >= vecSize) throw std::out_of_range("Invalid index");
+    return (*this)[index];
+}
+
+template<typename Growth, typename... Fields>
+typename BasicSoAVector<Growth, Fields...>::Row BasicSoAVector<Growth, Fields...>::front() {
+    if (vecSize == 0) throw std::out_of_range("Empty array");
+    return (*this)[0];
+}
+
+template<typename Growth, typename... Fields>
+typename BasicSoAVector<Growth, Fields...>::Row BasicSoAVector<Growth, Fields...>::back() {
+    if (vecSize == 0) throw std::out_of_range("Empty array");
+    return (*this)[vecSize - 1];
+}
+
+template<typename Growth, typename... Fields>
+void BasicSoAVector<Growth, Fields...>::push_back(const Fields&... fields) {
+    emplace_back(fields...);
+}
+
+template<typename Growth, typename... Fields>
+void BasicSoAVector<Growth, Fields...>::push_back(Fields&&... fields) { // avoids unnecessary copies
+    emplace_back(std::move(fields)...);
+}
+
+template<typename Growth, typename... Fields>
+template<typename... args>
+void BasicSoAVector<Growth, Fields...>::emplace_back(args&&... myArgs) {
+    static_assert(sizeof...(args) == sizeof...(Fields), "emplace_back takes one argument per field");
+
+    if (vecSize == vecCapacity) {
+        // the arguments may refer into our own columns, so build the row before they move
+        std::tuple<Fields...> row{std::forward<args>(myArgs)...};
+        grow(vecSize + 1);
+        constructRow(vecSize, std::move(row));
+    } else {
+        constructRow(vecSize, std::forward_as_tuple(std::forward<args>(myArgs)...));
+    }
+    ++vecSize;
+}
+
+template<typename Growth, typename... Fields>
+void BasicSoAVector<Growth, Fields...>::pop_back() {
+    if (vecSize == 0) throw std::out_of_range("Empty array");
+    --vecSize;
+    destroyRows(vecSize, vecSize + 1);
+}
+
+template<typename Growth, typename... Fields>
+void BasicSoAVector<Growth, Fields...>::erase(size_t n) {
+    if (n >= vecSize) {
+        throw std::out_of_range("Invalid index");
+    }
+
+    destroyRows(n, n + 1);
+    forEachColumn([&](auto I) { shiftLeft(std::get<decltype(I)::value>(columns), vecSize, n, 1); });
+    --vecSize;
+}
+
+template<typename Growth, typename... Fields>
+void BasicSoAVector<Growth, Fields...>::clear() {
+    destroyRows(0, vecSize);
+    vecSize = 0;
+}
+
+template<typename Growth, typename... Fields>
+bool BasicSoAVector<Growth, Fields...>::isEmpty() const {
+    return vecSize == 0;
+}
+
+template<typename Growth, typename... Fields>
+void BasicSoAVector<Growth, Fields...>::swap(size_t a, size_t b) {
+    forEachColumn([&](auto I) {
+        auto* column = std::get<decltype(I)::value>(columns);
+        std::swap(column[a], column[b]);
+    });
+}
+
+template<typename Growth, typename... Fields>
+std::ostream& operator<<(std::ostream& out, const BasicSoAVector<Growth, Fields...>& v) {
+    out << "{";
+    for (size_t i = 0; i < v.vecSize; ++i) {
+        out << "(";
+        std::apply([&out](const Fields&... field) {
+            size_t n = 0;
+            ((out << (n++ ? ", " : "") << field), ...);
+        }, v[i]);
+        out << ")";
+        if (i != v.vecSize - 1) out << ", ";
+    }
+    out << "}" << std::endl;
+    return out;
+}
+
+template<typename Growth, typename... Fields>
+BasicSoAVector<Growth, Fields...>::~BasicSoAVector() {
+    release();
+}
+
+// Fails every [failEvery]th allocation, to exercise the paths that must leave the columns intact
+class FlakyResource : public std::pmr::memory_resource {
+    size_t allocations = 0;
+    size_t failEvery;
+
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            if (++allocations % failEvery == 0) throw std::bad_alloc();
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        void do_deallocate(void* memory, size_t bytes, size_t alignment) override {
+            std::pmr::new_delete_resource()->deallocate(memory, bytes, alignment);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    public:
+        explicit FlakyResource(size_t failEvery) : failEvery{failEvery} {}
+};
+
+void testSoAVectorClass() {
+    SoAVector<int, double, std::string> trades; // id, price, symbol
+
+    trades.push_back(1, 101.5, "ACME");
+    trades.push_back(2, 99.25, "INIT");
+    trades.emplace_back(3, 250.0, "GLOBEX");
+    std::cout << trades;
+
+    auto [id, price, symbol] = trades[1]; // row proxy: references into the columns
+    price = 100.0;
+    symbol += "-X";
+    LOG("Trade " << id << " repriced: " << std::get<1>(trades[1]))
+
+    trades.swap(0, 2);
+    trades.erase(1);
+    std::cout << trades;
+
+    for (auto row : trades) LOG("Symbol: " << std::get<2>(row))
+
+    SoAVector<int, double, std::string> copy{trades};
+    copy.pop_back();
+    std::cout << copy;
+
+    SoAVector<unsigned, float> ticks;
+    for (unsigned i = 0; i < 100000; ++i) ticks.push_back(i, (float) (i % 100) / 4);
+
+    ColumnSpan<float> prices = ticks.column<1>(); // contiguous and 64-byte aligned: a SIMD-friendly scan
+    LOG("Price column aligned: " << ((uintptr_t) prices.begin() % columnAlignment == 0))
+    LOG("Price sum: " << prices.sum() << ", max: " << prices.max())
+
+    ticks.resize(3);
+    ticks.shrink_to_fit();
+    std::cout << ticks;
+
+    SoAVector<int, double, std::string> moved{std::move(trades)};
+    LOG("Moved size: " << moved.size() << ", source size: " << trades.size())
+
+    FlakyResource flaky{5}; // three columns per grow, so some grows fail on their second or third column
+    SoAVector<int, double, std::string> orders{&flaky};
+    size_t failedGrows = 0;
+    for (int i = 0; i < 200; ++i) {
+        try {
+            orders.push_back(i, i * 0.5, std::to_string(i));
+        } catch (const std::bad_alloc&) {
+            ++failedGrows;
+        }
+    }
+    bool intact = true;
+    for (size_t i = 0; i < orders.size(); ++i) intact = intact && std::get<2>(orders[i]) == std::to_string(std::get<0>(orders[i]));
+    LOG("Failed grows: " << failedGrows << ", rows kept: " << orders.size() << ", intact: " << intact)
+}
+
+int main() {
+    testSoAVectorClass();
+}
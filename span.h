@@ -0,0 +1,407 @@
+// C++ Data Structures
+
+#ifndef SPAN_H
+#define SPAN_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "parallelSort.h"
+#include "radixSort.h"
+#include "simdKernels.h"
+
+/* Span
+- A non-owning view of a contiguous run of elements: just a pointer and a length, so it is copied
+  by value and slicing it (first, last, subspan, chunks) never allocates or copies elements
+- Span<T> converts to Span<const T>; Array, Vector and FixedArray hand out spans with span()
+- sort, find, count and the SIMD reductions work on any span, so a pipeline stage can sort or scan
+  its own part of one big buffer
+- chunks(n) and split(parts) cut a span into pieces for handing out to worker threads
+- StridedSpan visits every stride-th element (a matrix column, one channel of interleaved samples);
+  it keeps the same interface, with plain loops where the elements aren't contiguous
+*/
+
+template<typename T>
+class StridedSpan;
+
+template<typename T>
+class Chunks;
+
+template<typename T>
+class Span {
+    T* ptr;
+    size_t length;
+    public:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        constexpr Span() : ptr{nullptr}, length{0} {}
+        constexpr Span(T* data, size_t size) : ptr{data}, length{size} {}
+        constexpr Span(T* first, T* last) : ptr{first}, length{static_cast<size_t>(last - first)} {}
+        template<size_t N>
+        constexpr Span(T (&array)[N]) : ptr{array}, length{N} {}
+        template<typename U, typename = std::enable_if_t<std::is_convertible<U (*)[], T (*)[]>::value>>
+        constexpr Span(const Span<U>& other) : ptr{other.getData()}, length{other.size()} {} // Span<T> -> Span<const T>
+
+        constexpr size_t size() const { return length; }
+        constexpr size_t sizeBytes() const { return length * sizeof(T); }
+        constexpr bool isEmpty() const { return length == 0; }
+        constexpr T* getData() const { return ptr; }
+        constexpr T& operator[](size_t index) const { return ptr[index]; }
+        constexpr T& at(size_t index) const;
+        constexpr T& front() const { return ptr[0]; }
+        constexpr T& back() const { return ptr[length - 1]; }
+
+        typedef T* Iterator;
+        constexpr Iterator begin() const { return ptr; }
+        constexpr Iterator end() const { return ptr + length; }
+
+        // Slicing: each returns a view into the same elements, and throws if it would run off the end
+        constexpr Span first(size_t count) const;
+        constexpr Span last(size_t count) const;
+        constexpr Span subspan(size_t offset, size_t count = npos) const; // npos: up to the end
+        Chunks<T> chunks(size_t chunkSize) const; // pieces of chunkSize elements, the last may be shorter
+        Chunks<T> split(size_t parts) const; // at most [parts] pieces of near-equal size
+        StridedSpan<T> strided(size_t step, size_t offset = 0) const; // elements offset, offset + step, ...
+
+        void fill(const T& value) const;
+        void sort() const; // radix sort for integer and float elements
+        template<typename KeyOf>
+        void sortByKey(KeyOf keyOf) const; // stable; keyOf(element) returns an integer, float or double
+        void parallelSort(unsigned threads = std::thread::hardware_concurrency()) const;
+
+        // Vectorized (AVX-512/AVX2/SSE4.2, picked at runtime) for arithmetic T, plain loops otherwise
+        Iterator find(const T& value) const;
+        size_t count(const T& value) const;
+        bool contains(const T& value) const;
+        std::remove_const_t<T> min() const;
+        std::remove_const_t<T> max() const;
+        std::pair<std::remove_const_t<T>, std::remove_const_t<T>> minmax() const;
+        SumType<std::remove_const_t<T>> sum() const;
+        SumType<std::remove_const_t<T>> dot(Span<const T> other) const;
+};
+
+template<typename T, size_t N>
+Span(T (&)[N]) -> Span<T>;
+
+// The pieces of a span, produced lazily: iterating yields one Span per chunk
+template<typename T>
+class Chunks {
+    Span<T> whole;
+    size_t chunkSize;
+    public:
+        Chunks(Span<T> whole, size_t chunkSize) : whole{whole}, chunkSize{chunkSize} {}
+        size_t size() const { return (whole.size() + chunkSize - 1) / chunkSize; }
+        Span<T> operator[](size_t index) const {
+            size_t offset = index * chunkSize;
+            return whole.subspan(offset, std::min(chunkSize, whole.size() - offset));
+        }
+
+        class Iterator {
+            const Chunks* chunks;
+            size_t index;
+            public:
+                Iterator(const Chunks* chunks, size_t index) : chunks{chunks}, index{index} {}
+                Span<T> operator*() const { return (*chunks)[index]; }
+                Iterator& operator++() { ++index; return *this; }
+                bool operator==(const Iterator& other) const { return index == other.index; }
+                bool operator!=(const Iterator& other) const { return index != other.index; }
+        };
+        Iterator begin() const { return Iterator{this, 0}; }
+        Iterator end() const { return Iterator{this, size()}; }
+};
+
+template<typename T>
+class StridedSpan {
+    T* ptr;
+    size_t length;
+    ptrdiff_t step; // in elements; negative walks backwards
+    public:
+        StridedSpan() : ptr{nullptr}, length{0}, step{1} {}
+        StridedSpan(T* data, size_t size, ptrdiff_t stride) : ptr{data}, length{size}, step{stride} {}
+        template<typename U, typename = std::enable_if_t<std::is_convertible<U (*)[], T (*)[]>::value>>
+        StridedSpan(Span<U> span) : ptr{span.getData()}, length{span.size()}, step{1} {}
+        template<typename U, typename = std::enable_if_t<std::is_convertible<U (*)[], T (*)[]>::value>>
+        StridedSpan(const StridedSpan<U>& other) : ptr{other.getData()}, length{other.size()}, step{other.stride()} {}
+
+        size_t size() const { return length; }
+        ptrdiff_t stride() const { return step; }
+        bool isEmpty() const { return length == 0; }
+        bool isContiguous() const { return step == 1 || length <= 1; }
+        T* getData() const { return ptr; }
+        T& operator[](size_t index) const { return ptr[(ptrdiff_t) index * step]; }
+        T& at(size_t index) const;
+        T& front() const { return ptr[0]; }
+        T& back() const { return (*this)[length - 1]; }
+
+        class Iterator {
+            T* p;
+            ptrdiff_t step;
+            public:
+                typedef std::random_access_iterator_tag iterator_category;
+                typedef std::remove_const_t<T> value_type;
+                typedef ptrdiff_t difference_type;
+                typedef T* pointer;
+                typedef T& reference;
+
+                Iterator() : p{nullptr}, step{1} {}
+                Iterator(T* p, ptrdiff_t step) : p{p}, step{step} {}
+                T& operator*() const { return *p; }
+                T* operator->() const { return p; }
+                T& operator[](ptrdiff_t n) const { return p[n * step]; }
+                Iterator& operator++() { p += step; return *this; }
+                Iterator operator++(int) { Iterator old = *this; p += step; return old; }
+                Iterator& operator--() { p -= step; return *this; }
+                Iterator operator--(int) { Iterator old = *this; p -= step; return old; }
+                Iterator& operator+=(ptrdiff_t n) { p += n * step; return *this; }
+                Iterator& operator-=(ptrdiff_t n) { p -= n * step; return *this; }
+                Iterator operator+(ptrdiff_t n) const { return Iterator{p + n * step, step}; }
+                friend Iterator operator+(ptrdiff_t n, const Iterator& it) { return it + n; }
+                Iterator operator-(ptrdiff_t n) const { return Iterator{p - n * step, step}; }
+                ptrdiff_t operator-(const Iterator& other) const { return (p - other.p) / step; }
+                bool operator==(const Iterator& other) const { return p == other.p; }
+                bool operator!=(const Iterator& other) const { return p != other.p; }
+                bool operator<(const Iterator& other) const { return other - *this > 0; }
+                bool operator>(const Iterator& other) const { return other < *this; }
+                bool operator<=(const Iterator& other) const { return !(other < *this); }
+                bool operator>=(const Iterator& other) const { return !(*this < other); }
+        };
+        Iterator begin() const { return Iterator{ptr, step}; }
+        Iterator end() const { return Iterator{ptr + (ptrdiff_t) length * step, step}; }
+
+        StridedSpan subspan(size_t offset, size_t count = Span<T>::npos) const;
+        StridedSpan strided(size_t every) const; // every [every]-th element of this view
+        Span<T> contiguous() const; // the same elements as a Span; throws unless isContiguous()
+
+        void fill(const T& value) const;
+        void sort() const; // introsort through the strided iterator; radix sort when contiguous
+
+        // Contiguous views go through the SIMD kernels, the rest use plain loops
+        size_t find(const T& value) const; // index of the first match, or size()
+        size_t count(const T& value) const;
+        bool contains(const T& value) const;
+        std::remove_const_t<T> min() const;
+        std::remove_const_t<T> max() const;
+        std::pair<std::remove_const_t<T>, std::remove_const_t<T>> minmax() const;
+        SumType<std::remove_const_t<T>> sum() const;
+        SumType<std::remove_const_t<T>> dot(StridedSpan<const T> other) const;
+};
+
+template<typename T>
+constexpr T& Span<T>::at(size_t index) const {
+    if (index >= length) {
+        throw std::out_of_range("Invalid index");
+    }
+    return ptr[index];
+}
+
+template<typename T>
+constexpr Span<T> Span<T>::first(size_t count) const {
+    if (count > length) throw std::out_of_range("Invalid index");
+    return Span{ptr, count};
+}
+
+template<typename T>
+constexpr Span<T> Span<T>::last(size_t count) const {
+    if (count > length) throw std::out_of_range("Invalid index");
+    return Span{ptr + length - count, count};
+}
+
+template<typename T>
+constexpr Span<T> Span<T>::subspan(size_t offset, size_t count) const {
+    if (offset > length) throw std::out_of_range("Invalid index");
+    if (count == npos) count = length - offset;
+    if (count > length - offset) throw std::out_of_range("Invalid index");
+    return Span{ptr + offset, count};
+}
+
+template<typename T>
+Chunks<T> Span<T>::chunks(size_t chunkSize) const {
+    if (chunkSize == 0) throw std::invalid_argument("Chunk size must be positive");
+    return Chunks<T>{*this, chunkSize};
+}
+
+template<typename T>
+Chunks<T> Span<T>::split(size_t parts) const {
+    if (parts == 0) throw std::invalid_argument("Part count must be positive");
+    return Chunks<T>{*this, std::max<size_t>(1, (length + parts - 1) / parts)};
+}
+
+template<typename T>
+StridedSpan<T> Span<T>::strided(size_t step, size_t offset) const {
+    if (step == 0) throw std::invalid_argument("Stride must be positive");
+    if (offset > length) throw std::out_of_range("Invalid index");
+    return StridedSpan<T>{ptr + offset, (length - offset + step - 1) / step, (ptrdiff_t) step};
+}
+
+template<typename T>
+void Span<T>::fill(const T& value) const {
+    std::fill(begin(), end(), value);
+}
+
+template<typename T>
+void Span<T>::sort() const {
+    sortRange(begin(), end());
+}
+
+template<typename T>
+template<typename KeyOf>
+void Span<T>::sortByKey(KeyOf keyOf) const {
+    radixSortByKey(begin(), end(), keyOf);
+}
+
+template<typename T>
+void Span<T>::parallelSort(unsigned threads) const { // falls back to sort() for small spans
+    ::parallelSort(begin(), end(), threads);
+}
+
+template<typename T>
+typename Span<T>::Iterator Span<T>::find(const T& value) const {
+    return begin() + simdFind<std::remove_const_t<T>>(ptr, length, value);
+}
+
+template<typename T>
+size_t Span<T>::count(const T& value) const {
+    return simdCount<std::remove_const_t<T>>(ptr, length, value);
+}
+
+template<typename T>
+bool Span<T>::contains(const T& value) const {
+    return simdFind<std::remove_const_t<T>>(ptr, length, value) != length;
+}
+
+template<typename T>
+std::remove_const_t<T> Span<T>::min() const {
+    return minmax().first;
+}
+
+template<typename T>
+std::remove_const_t<T> Span<T>::max() const {
+    return minmax().second;
+}
+
+template<typename T>
+std::pair<std::remove_const_t<T>, std::remove_const_t<T>> Span<T>::minmax() const {
+    if (length == 0) throw std::out_of_range("Empty array");
+    return simdMinMax<std::remove_const_t<T>>(ptr, length);
+}
+
+template<typename T>
+SumType<std::remove_const_t<T>> Span<T>::sum() const {
+    return simdSum<std::remove_const_t<T>>(ptr, length);
+}
+
+template<typename T>
+SumType<std::remove_const_t<T>> Span<T>::dot(Span<const T> other) const {
+    if (other.size() != length) throw std::invalid_argument("Size mismatch");
+    return simdDot<std::remove_const_t<T>>(ptr, other.getData(), length);
+}
+
+template<typename T>
+T& StridedSpan<T>::at(size_t index) const {
+    if (index >= length) {
+        throw std::out_of_range("Invalid index");
+    }
+    return (*this)[index];
+}
+
+template<typename T>
+StridedSpan<T> StridedSpan<T>::subspan(size_t offset, size_t count) const {
+    if (offset > length) throw std::out_of_range("Invalid index");
+    if (count == Span<T>::npos) count = length - offset;
+    if (count > length - offset) throw std::out_of_range("Invalid index");
+    return StridedSpan{ptr + (ptrdiff_t) offset * step, count, step};
+}
+
+template<typename T>
+StridedSpan<T> StridedSpan<T>::strided(size_t every) const {
+    if (every == 0) throw std::invalid_argument("Stride must be positive");
+    return StridedSpan{ptr, (length + every - 1) / every, step * (ptrdiff_t) every};
+}
+
+template<typename T>
+Span<T> StridedSpan<T>::contiguous() const {
+    if (!isContiguous()) throw std::invalid_argument("Span is not contiguous");
+    return Span<T>{ptr, length};
+}
+
+template<typename T>
+void StridedSpan<T>::fill(const T& value) const {
+    for (size_t i = 0; i < length; ++i) (*this)[i] = value;
+}
+
+template<typename T>
+void StridedSpan<T>::sort() const {
+    if (isContiguous()) sortRange(ptr, ptr + length);
+    else std::sort(begin(), end());
+}
+
+template<typename T>
+size_t StridedSpan<T>::find(const T& value) const {
+    if (isContiguous()) return contiguous().find(value) - ptr;
+    for (size_t i = 0; i < length; ++i)
+        if ((*this)[i] == value) return i;
+    return length;
+}
+
+template<typename T>
+size_t StridedSpan<T>::count(const T& value) const {
+    if (isContiguous()) return contiguous().count(value);
+    size_t count = 0;
+    for (size_t i = 0; i < length; ++i)
+        if ((*this)[i] == value) ++count;
+    return count;
+}
+
+template<typename T>
+bool StridedSpan<T>::contains(const T& value) const {
+    return find(value) != length;
+}
+
+template<typename T>
+std::remove_const_t<T> StridedSpan<T>::min() const {
+    return minmax().first;
+}
+
+template<typename T>
+std::remove_const_t<T> StridedSpan<T>::max() const {
+    return minmax().second;
+}
+
+template<typename T>
+std::pair<std::remove_const_t<T>, std::remove_const_t<T>> StridedSpan<T>::minmax() const {
+    if (length == 0) throw std::out_of_range("Empty array");
+    if (isContiguous()) return contiguous().minmax();
+
+    std::pair<std::remove_const_t<T>, std::remove_const_t<T>> result{front(), front()};
+    for (size_t i = 1; i < length; ++i) {
+        if ((*this)[i] < result.first) result.first = (*this)[i];
+        if (result.second < (*this)[i]) result.second = (*this)[i];
+    }
+    return result;
+}
+
+template<typename T>
+SumType<std::remove_const_t<T>> StridedSpan<T>::sum() const {
+    if (isContiguous()) return contiguous().sum();
+    SumType<std::remove_const_t<T>> sum{};
+    for (size_t i = 0; i < length; ++i) sum += (SumType<std::remove_const_t<T>>) (*this)[i];
+    return sum;
+}
+
+template<typename T>
+SumType<std::remove_const_t<T>> StridedSpan<T>::dot(StridedSpan<const T> other) const {
+    if (other.size() != length) throw std::invalid_argument("Size mismatch");
+    if (isContiguous() && other.isContiguous()) return contiguous().dot(other.contiguous());
+
+    typedef SumType<std::remove_const_t<T>> Sum;
+    Sum sum{};
+    for (size_t i = 0; i < length; ++i) sum += (Sum) (*this)[i] * (Sum) other[i];
+    return sum;
+}
+
+#endif
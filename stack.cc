@@ -7,29 +7,54 @@
 #define LOG(x)
 #endif
 
+#include <array>
+#include <atomic>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "growthPolicy.h"
+#include "nodeAllocation.h"
+#include "nodePool.h"
+#include "relocate.h"
 
 template<typename T>
 class Stack {
     struct Node {
         T data;
         Node* next;
+
+        template<typename... Args> // builds [data] in place from the arguments
+        Node(Node* next, Args&&... args) : data(std::forward<Args>(args)...), next{next} {}
     };
 
     Node* pTop;
     size_t pSize;
+    std::pmr::memory_resource* resource;
+    NodePool nodePool; // every node comes from here; [resource] only supplies its slabs
 
     public:
         Stack();
+        explicit Stack(std::pmr::memory_resource* resource); // e.g. a per-request arena or a pool
         Stack(const Stack& other);
         Stack(Stack&& other);
         Stack& operator=(const Stack& other);
         Stack& operator=(Stack&& other);
+        std::pmr::memory_resource* getResource() const;
         constexpr size_t size() const noexcept;
         T& top();
         const T& top() const;
         void push(const T& elem);
         void push(T&& elem);
+        template<typename... args>
+        void emplace(args&&... myArgs);
         void pop();
         bool isEmpty();
         class Iterator {
@@ -51,30 +76,34 @@ class Stack {
 };
 
 template<typename T>
-Stack<T>::Stack() : pTop{nullptr}, pSize{0} {}
+Stack<T>::Stack() : Stack{std::pmr::get_default_resource()} {}
+
+template<typename T>
+Stack<T>::Stack(std::pmr::memory_resource* resource) : pTop{nullptr}, pSize{0}, resource{resource}, nodePool{sizeof(Node), alignof(Node), resource} {}
 
 template<typename T>
-Stack<T>::Stack(const Stack& other) : pTop{nullptr}, pSize{0} {
+Stack<T>::Stack(const Stack& other) : pTop{nullptr}, pSize{0}, resource{std::pmr::get_default_resource()},
+    nodePool{sizeof(Node), alignof(Node), resource} {
     Node* otherTraverser = other.pTop;
     Node* thisTraverser = nullptr;
     Node* thisNextTraverser = nullptr;
 
     if (otherTraverser) {
-        pTop = new Node{otherTraverser->data, nullptr};
+        pTop = createNode<Node>(&nodePool, nullptr, otherTraverser->data);
         thisTraverser = pTop;
     }
 
     while (otherTraverser) {
         ++pSize;
         otherTraverser = otherTraverser->next;
-        thisNextTraverser = otherTraverser? new Node{otherTraverser->data, nullptr} : otherTraverser;
+        thisNextTraverser = otherTraverser? createNode<Node>(&nodePool, nullptr, otherTraverser->data) : otherTraverser;
         thisTraverser->next = thisNextTraverser;
         if (thisNextTraverser) thisTraverser = thisTraverser->next;
     }
 }
 
 template<typename T>
-Stack<T>::Stack(Stack&& other) : pTop{other.pTop}, pSize{other.pSize} {
+Stack<T>::Stack(Stack&& other) : pTop{other.pTop}, pSize{other.pSize}, resource{other.resource}, nodePool{std::move(other.nodePool)} {
     other.pTop = nullptr;
     other.pSize = 0;
 }
@@ -89,14 +118,14 @@ Stack<T>& Stack<T>::operator=(const Stack& other) {
     Node* thisNextTraverser = nullptr;
 
     if (otherTraverser) {
-        pTop = new Node{otherTraverser->data, nullptr};
+        pTop = createNode<Node>(&nodePool, nullptr, otherTraverser->data);
         thisTraverser = pTop;
     }
 
     while (otherTraverser) {
         ++pSize;
         otherTraverser = otherTraverser->next;
-        thisNextTraverser = otherTraverser? new Node{otherTraverser->data, nullptr} : otherTraverser;
+        thisNextTraverser = otherTraverser? createNode<Node>(&nodePool, nullptr, otherTraverser->data) : otherTraverser;
         thisTraverser->next = thisNextTraverser;
         if (thisNextTraverser) thisTraverser = thisTraverser->next;
     }
@@ -108,10 +137,15 @@ template<typename T>
 Stack<T>& Stack<T>::operator=(Stack&& other) {
     std::swap(pTop, other.pTop);
     std::swap(pSize, other.pSize);
+    std::swap(resource, other.resource);
+    nodePool.swap(other.nodePool); // the nodes must go back to the pool they came from
 
     return *this;
 }
 
+template<typename T>
+std::pmr::memory_resource* Stack<T>::getResource() const { return resource; }
+
 template<typename T>
 constexpr size_t Stack<T>::size() const noexcept { return pSize; }
 
@@ -129,7 +163,7 @@ const T& Stack<T>::top() const {
 
 template<typename T>
 void Stack<T>::push(const T& elem) {
-    Node* newTop = new Node{elem, pTop};
+    Node* newTop = createNode<Node>(&nodePool, pTop, elem);
     pTop = newTop;
 
     ++pSize;
@@ -137,19 +171,26 @@ void Stack<T>::push(const T& elem) {
 
 template<typename T>
 void Stack<T>::push(T&& elem) {
-    Node* newTop = new Node{elem, pTop};
+    Node* newTop = createNode<Node>(&nodePool, pTop, std::move(elem));
     pTop = newTop;
 
     ++pSize;
 }
 
+template<typename T>
+template<typename... args>
+void Stack<T>::emplace(args&&... myArgs) {
+    pTop = createNode<Node>(&nodePool, pTop, std::forward<args>(myArgs)...);
+    ++pSize;
+}
+
 template<typename T>
 void Stack<T>::pop() {
     Node* toBeDeleted = pTop;
     pTop = pTop->next;
 
     --pSize;
-    delete toBeDeleted;
+    destroyNode(&nodePool, toBeDeleted);
 }
 
 template<typename T>
@@ -200,14 +241,11 @@ std::ostream& operator<<(std::ostream& out, const Stack<T>& st) {
 
 template<typename T>
 void Stack<T>::clear() {
-    Node* traverser = pTop;
-    Node* tempNode = nullptr;
-
-    while(traverser) {
-        tempNode = traverser->next;
-        delete traverser;
-        traverser = tempNode;
+    if constexpr (!std::is_trivially_destructible<T>::value) {
+        for (Node* traverser = pTop; traverser; traverser = traverser->next)
+            traverser->data.~T();
     }
+    nodePool.release(); // hands back whole slabs instead of freeing node by node
 
     pSize = 0;
     pTop = nullptr;
@@ -215,14 +253,365 @@ void Stack<T>::clear() {
 
 template<typename T>
 Stack<T>::~Stack() {
-    Node* traverser = pTop;
-    Node* tempNode = nullptr;
+    if constexpr (!std::is_trivially_destructible<T>::value) {
+        for (Node* traverser = pTop; traverser; traverser = traverser->next)
+            traverser->data.~T();
+    }
+    // nodePool hands back whole slabs when it's destroyed
+}
+
+/* Array Stack
+- The same top/push/pop/iterator interface as Stack, but the elements sit in one contiguous buffer
+  that grows by a growth policy (doubling by default), so push and pop are amortized O(1) with no
+  allocation per element and iteration walks memory in order
+- reserve() sizes the buffer up front for workloads whose depth is known (DFS over n vertices)
+- Iterates from the top down, like Stack
+*/
+
+template<typename T, typename Growth = DoublingGrowth>
+class ArrayStack {
+    T* data;
+    size_t stackSize;
+    size_t stackCapacity;
+    std::pmr::memory_resource* resource;
+
+        void grow(size_t required);
+    public:
+        ArrayStack();
+        explicit ArrayStack(std::pmr::memory_resource* resource);
+        ArrayStack(const ArrayStack& other);
+        ArrayStack(ArrayStack&& other);
+        ArrayStack& operator=(const ArrayStack& other);
+        ArrayStack& operator=(ArrayStack&& other);
+        std::pmr::memory_resource* getResource() const;
+        constexpr size_t size() const noexcept;
+        size_t capacity() const;
+        void reserve(size_t newCap);
+        void shrink_to_fit();
+        T& top();
+        const T& top() const;
+        void push(const T& elem);
+        void push(T&& elem);
+        template<typename... args>
+        void emplace(args&&... myArgs);
+        void pop();
+        bool isEmpty() const;
+        void clear();
+
+        typedef std::reverse_iterator<T*> Iterator; // top first
+        Iterator begin() const { return Iterator{data + stackSize}; }
+        Iterator end() const { return Iterator{data}; }
+
+        template <typename U, typename G>
+        friend std::ostream& operator<<(std::ostream& out, const ArrayStack<U, G>& st);
+        ~ArrayStack();
+};
+
+template<typename T, typename Growth>
+void ArrayStack<T, Growth>::grow(size_t required) {
+    size_t newCap = Growth::grow(stackCapacity, required, sizeof(T));
+    data = reallocateBuffer(data, stackSize, stackCapacity, newCap, resource); // realloc for trivially copyable T
+    stackCapacity = newCap;
+}
+
+template<typename T, typename Growth>
+ArrayStack<T, Growth>::ArrayStack() : ArrayStack{heapResource()} {}
+
+template<typename T, typename Growth>
+ArrayStack<T, Growth>::ArrayStack(std::pmr::memory_resource* resource) :
+    data{nullptr}, stackSize{0}, stackCapacity{0}, resource{resource} {}
+
+template<typename T, typename Growth>
+ArrayStack<T, Growth>::ArrayStack(const ArrayStack& other) : ArrayStack{heapResource()} {
+    data = allocateBuffer<T>(other.stackSize, resource);
+    stackCapacity = other.stackSize;
+    uninitializedCopy(other.data, other.stackSize, data);
+    stackSize = other.stackSize;
+}
+
+template<typename T, typename Growth>
+ArrayStack<T, Growth>::ArrayStack(ArrayStack&& other) :
+    data{other.data}, stackSize{other.stackSize}, stackCapacity{other.stackCapacity}, resource{other.resource} {
+        other.data = nullptr;
+        other.stackSize = 0;
+        other.stackCapacity = 0;
+    }
+
+template<typename T, typename Growth>
+ArrayStack<T, Growth>& ArrayStack<T, Growth>::operator=(const ArrayStack& other) {
+    if (this == &other) return *this;
+    clear();
+
+    if (stackCapacity < other.stackSize) { // reuse the buffer when it's already big enough
+        deallocateBuffer(data, stackCapacity, resource);
+        data = nullptr;
+        stackCapacity = 0;
+        data = allocateBuffer<T>(other.stackSize, resource);
+        stackCapacity = other.stackSize;
+    }
+
+    uninitializedCopy(other.data, other.stackSize, data);
+    stackSize = other.stackSize;
+    return *this;
+}
+
+template<typename T, typename Growth>
+ArrayStack<T, Growth>& ArrayStack<T, Growth>::operator=(ArrayStack&& other) {
+    if (this == &other) return *this;
+    if (!resource->is_equal(*other.resource)) { // can't free the other buffer through our resource
+        clear();
+        reserve(other.stackSize);
+        relocateRange(other.data, other.stackSize, data);
+        stackSize = other.stackSize;
+        other.stackSize = 0;
+        return *this;
+    }
+
+    std::swap(data, other.data);
+    std::swap(stackSize, other.stackSize);
+    std::swap(stackCapacity, other.stackCapacity);
+    return *this;
+}
+
+template<typename T, typename Growth>
+std::pmr::memory_resource* ArrayStack<T, Growth>::getResource() const { return resource; }
+
+template<typename T, typename Growth>
+constexpr size_t ArrayStack<T, Growth>::size() const noexcept { return stackSize; }
+
+template<typename T, typename Growth>
+size_t ArrayStack<T, Growth>::capacity() const { return stackCapacity; }
+
+template<typename T, typename Growth>
+void ArrayStack<T, Growth>::reserve(size_t newCap) {
+    if (newCap <= stackCapacity) return;
+    data = reallocateBuffer(data, stackSize, stackCapacity, newCap, resource);
+    stackCapacity = newCap;
+}
+
+template<typename T, typename Growth>
+void ArrayStack<T, Growth>::shrink_to_fit() {
+    if (stackSize == stackCapacity) return;
+    data = reallocateBuffer(data, stackSize, stackCapacity, stackSize, resource);
+    stackCapacity = stackSize;
+}
+
+template<typename T, typename Growth>
+T& ArrayStack<T, Growth>::top() {
+    if (stackSize == 0) throw std::invalid_argument("Stack TOP is NULL");
+    return data[stackSize - 1];
+}
+
+template<typename T, typename Growth>
+const T& ArrayStack<T, Growth>::top() const {
+    if (stackSize == 0) throw std::invalid_argument("Stack TOP is NULL");
+    return data[stackSize - 1];
+}
+
+template<typename T, typename Growth>
+void ArrayStack<T, Growth>::push(const T& elem) {
+    emplace(elem);
+}
+
+template<typename T, typename Growth>
+void ArrayStack<T, Growth>::push(T&& elem) {
+    emplace(std::move(elem));
+}
+
+template<typename T, typename Growth>
+template<typename... args>
+void ArrayStack<T, Growth>::emplace(args&&... myArgs) {
+    if (stackSize == stackCapacity) {
+        T elem(std::forward<args>(myArgs)...); // the arguments may refer into the buffer that's about to move
+        grow(stackSize + 1);
+        new(&data[stackSize]) T(std::move(elem));
+    } else {
+        new(&data[stackSize]) T(std::forward<args>(myArgs)...);
+    }
+    ++stackSize;
+}
+
+template<typename T, typename Growth>
+void ArrayStack<T, Growth>::pop() {
+    if (stackSize == 0) return;
+    --stackSize;
+    data[stackSize].~T();
+}
+
+template<typename T, typename Growth>
+bool ArrayStack<T, Growth>::isEmpty() const { return stackSize == 0; }
+
+template<typename T, typename Growth>
+void ArrayStack<T, Growth>::clear() {
+    destroyRange(data, stackSize);
+    stackSize = 0;
+}
 
-    while(traverser) {
-        tempNode = traverser->next;
-        delete traverser;
-        traverser = tempNode;
+template<typename T, typename Growth>
+std::ostream& operator<<(std::ostream& out, const ArrayStack<T, Growth>& st) {
+    out << "{";
+    for (auto it = st.begin(); it != st.end(); ++it) {
+        if (it != st.begin()) out << ", ";
+        out << *it;
     }
+    out << "}";
+    return out;
+}
+
+template<typename T, typename Growth>
+ArrayStack<T, Growth>::~ArrayStack() {
+    destroyRange(data, stackSize);
+    deallocateBuffer(data, stackCapacity, resource);
+}
+
+/* Persistent Stack
+- An immutable stack whose versions share their nodes: copying is O(1), and a push onto a copy
+  shares everything below the new top with the original (structural sharing), so a snapshot costs
+  one pointer instead of a copy of every node
+- push, emplace and pop only move this handle's top pointer and never change a node, so every
+  other copy keeps its own version
+- Nodes are reference counted and freed when the last version using them goes away. They come
+  from [resource], which copies share and which must outlive all of them
+- Nodes are never written after construction, so copies may be read from several threads at once
+*/
+
+template<typename T>
+class PersistentStack {
+    struct Node {
+        T data;
+        std::shared_ptr<Node> next;
+
+        template<typename... Args>
+        Node(std::shared_ptr<Node> next, Args&&... args) : data(std::forward<Args>(args)...), next{std::move(next)} {}
+        ~Node(); // unlinks the nodes no other version uses one at a time, so a long chain can't overflow the call stack
+    };
+
+    std::shared_ptr<Node> pTop;
+    size_t pSize;
+    std::pmr::memory_resource* resource;
+
+    public:
+        PersistentStack();
+        explicit PersistentStack(std::pmr::memory_resource* resource);
+        std::pmr::memory_resource* getResource() const;
+        size_t size() const noexcept;
+        const T& top() const;
+        void push(const T& elem);
+        void push(T&& elem);
+        template<typename... args>
+        void emplace(args&&... myArgs);
+        void pop(); // does nothing when empty
+        bool isEmpty() const;
+        class Iterator {
+                const Node* n;
+                explicit Iterator(const Node* n);
+            public:
+                const T& operator*() const;
+                bool operator!=(const Iterator& other) const;
+                Iterator& operator++();
+                friend class PersistentStack;
+        };
+
+        Iterator begin() const;
+        Iterator end() const;
+        template <typename U>
+        friend std::ostream& operator<<(std::ostream& out, const PersistentStack<U>& st);
+        void clear();
+};
+
+template<typename T>
+PersistentStack<T>::Node::~Node() {
+    std::shared_ptr<Node> rest = std::move(next);
+    while (rest && rest.use_count() == 1) {
+        std::atomic_thread_fence(std::memory_order_acquire); // use_count() is relaxed: order the last other owner's reads before we write
+        rest = std::move(rest->next);
+    }
+}
+
+template<typename T>
+PersistentStack<T>::PersistentStack() : PersistentStack{std::pmr::get_default_resource()} {}
+
+template<typename T>
+PersistentStack<T>::PersistentStack(std::pmr::memory_resource* resource) : pTop{nullptr}, pSize{0}, resource{resource} {}
+
+template<typename T>
+std::pmr::memory_resource* PersistentStack<T>::getResource() const { return resource; }
+
+template<typename T>
+size_t PersistentStack<T>::size() const noexcept { return pSize; }
+
+template<typename T>
+const T& PersistentStack<T>::top() const {
+    if (!pTop) throw std::invalid_argument("Stack TOP is NULL");
+    return pTop->data;
+}
+
+template<typename T>
+void PersistentStack<T>::push(const T& elem) {
+    emplace(elem);
+}
+
+template<typename T>
+void PersistentStack<T>::push(T&& elem) {
+    emplace(std::move(elem));
+}
+
+template<typename T>
+template<typename... args>
+void PersistentStack<T>::emplace(args&&... myArgs) {
+    pTop = std::allocate_shared<Node>(std::pmr::polymorphic_allocator<Node>{resource}, pTop, std::forward<args>(myArgs)...);
+    ++pSize;
+}
+
+template<typename T>
+void PersistentStack<T>::pop() {
+    if (!pTop) return;
+    pTop = pTop->next;
+    --pSize;
+}
+
+template<typename T>
+bool PersistentStack<T>::isEmpty() const { return pSize == 0; }
+
+template<typename T>
+PersistentStack<T>::Iterator::Iterator(const Node* n) : n{n} {}
+
+template<typename T>
+const T& PersistentStack<T>::Iterator::operator*() const {
+    return n->data;
+}
+
+template<typename T>
+bool PersistentStack<T>::Iterator::operator!=(const Iterator& other) const {
+    return other.n != n;
+}
+
+template<typename T>
+typename PersistentStack<T>::Iterator& PersistentStack<T>::Iterator::operator++() {
+    n = n->next.get();
+    return *this;
+}
+
+template<typename T>
+typename PersistentStack<T>::Iterator PersistentStack<T>::begin() const { return Iterator{pTop.get()}; }
+template<typename T>
+typename PersistentStack<T>::Iterator PersistentStack<T>::end() const { return Iterator{nullptr}; }
+
+template<typename T>
+std::ostream& operator<<(std::ostream& out, const PersistentStack<T>& st) {
+    out << "{";
+    for (auto it = st.begin(); it != st.end(); ++it) {
+        if (it != st.begin()) out << ", ";
+        out << *it;
+    }
+    out << "}";
+    return out;
+}
+
+template<typename T>
+void PersistentStack<T>::clear() {
+    pTop = nullptr; // other versions keep the nodes they share
+    pSize = 0;
 }
 
 Stack<std::string> getNewStack() {
@@ -257,6 +646,97 @@ void testStackClass() {
     examsHandedIn = getNewStack();
     std::cout << examsHandedIn << std::endl;
     std::cout << drillLine << std::endl;
+
+    std::pmr::monotonic_buffer_resource requestArena; // nodes are released all at once with the arena
+    Stack<std::string> callStack{&requestArena};
+    callStack.push("main");
+    callStack.push("parse");
+    callStack.push("lex");
+    callStack.pop();
+    std::cout << callStack << std::endl;
+
+    Stack<int> scratch; // popped nodes go on the pool's free list and get reused by the next push
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 100000; ++i) scratch.push(i);
+        while (!scratch.isEmpty()) scratch.pop();
+    }
+    for (int i = 0; i < 100000; ++i) scratch.push(i);
+    LOG(scratch.size()) // the destructor releases whole slabs without visiting the nodes
+
+    Stack<std::array<char, 8192>> pages; // too big for a slab: each node comes straight from upstream
+    for (int i = 0; i < 200; ++i) {
+        pages.push({});
+        pages.top()[0] = (char) (i % 100);
+        if (i % 4 == 3) pages.pop(); // freed one at a time
+    }
+    LOG("Pages: " << pages.size() << ", top starts with " << (int) pages.top()[0])
+    pages.clear(); // the rest go back with the pool's release()
+
+    Stack<std::pair<std::string, int>> frames;
+    frames.emplace("main", 1); // built in place inside the node
+    std::string caller = "parse";
+    frames.push({std::move(caller), 2});
+    LOG("Top frame: " << frames.top().first << ", moved-from caller empty: " << caller.empty())
+
+    ArrayStack<int> dfs; // one buffer: no allocation per push once it has grown
+    dfs.reserve(1 << 16);
+    long long visits = 0;
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 100000; ++i) dfs.push(i);
+        while (!dfs.isEmpty()) {
+            visits += dfs.top();
+            dfs.pop();
+        }
+    }
+    LOG("DFS visits: " << visits << ", capacity " << dfs.capacity())
+
+    ArrayStack<std::string> operands;
+    operands.push("2");
+    operands.emplace(3, '4'); // "444"
+    operands.push(operands.top()); // an element of the stack itself, pushed as the buffer grows
+    std::cout << operands << std::endl;
+    ArrayStack<std::string> saved = operands;
+    operands.pop();
+    for (auto& operand : saved) LOG("Saved operand " << operand)
+    ArrayStack<std::string> moved = std::move(operands);
+    std::cout << moved << std::endl;
+
+    try {
+        ArrayStack<int>{}.top();
+    } catch (const std::invalid_argument& e) {
+        LOG("Caught: " << e.what())
+    }
+
+    PersistentStack<std::string> path; // a backtracking search's choices, snapshotted at every step
+    path.push("a1");
+    path.push("b3");
+    PersistentStack<std::string> checkpoint = path; // O(1): shares both nodes
+    path.push("c5");
+    path.pop();
+    path.pop();
+    path.emplace(2, 'd'); // "dd", on top of the shared "a1"
+    std::cout << path << " " << checkpoint << std::endl;
+
+    std::vector<PersistentStack<int>> snapshots;
+    PersistentStack<int> depth;
+    for (int i = 0; i < 200000; ++i) {
+        depth.push(i);
+        if (i % 1000 == 0) snapshots.push_back(depth); // 200 snapshots, one copy of the nodes
+    }
+    snapshots.push_back(depth);
+    depth.clear();
+    LOG("Snapshot sizes: " << snapshots.front().size() << " .. " << snapshots.back().size() << ", top " << snapshots.back().top())
+
+    std::vector<std::thread> readers;
+    std::vector<long long> sums(4, 0);
+    for (int t = 0; t < 4; ++t) { // the newest versions share all but their top 1000 nodes
+        readers.emplace_back([&sums, t, version = std::move(snapshots[snapshots.size() - 1 - t])] {
+            for (int value : version) sums[t] += value;
+        }); // each reader drops its version on its own thread, so whichever is last frees the shared nodes
+    }
+    for (auto& reader : readers) reader.join();
+    LOG("Readers summed the newest version: " << (sums[0] == 199999LL * 200000 / 2))
+    snapshots.clear(); // frees a 200000-node chain without recursing through it
 }
 
 int main() {
@@ -0,0 +1,152 @@
+// C++ Data Structures
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/* Thread Pool
+- A fixed set of worker threads fed from one locked queue, so parallel code reuses threads
+  instead of creating and joining new ones on every call
+- submit() queues one task and returns a std::future for its result
+- run(count, body) calls body(0) ... body(count - 1) across the pool and returns once all of them
+  are done. The calling thread takes indices too, and the others claim them one at a time from
+  an atomic counter, so a slow index doesn't hold up the rest (dynamic scheduling)
+- Because the caller works through the indices itself, run() can be called from inside a task
+  without deadlocking, even when every worker is busy
+- ThreadPool::shared() is one lazily created pool for the whole program
+*/
+
+class ThreadPool {
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex lock;
+    std::condition_variable wake;
+    bool stopping;
+
+        void workerLoop();
+        void enqueue(std::function<void()> task);
+    public:
+        explicit ThreadPool(unsigned threads = std::max(1u, std::thread::hardware_concurrency()));
+        ThreadPool(const ThreadPool& other) = delete;
+        ThreadPool& operator=(const ThreadPool& other) = delete;
+        size_t size() const { return workers.size(); }
+        template<typename F>
+        auto submit(F task) -> std::future<decltype(task())>;
+        template<typename Body>
+        void run(size_t count, Body body); // exceptions are rethrown once every index has finished
+        static ThreadPool& shared();
+        ~ThreadPool(); // finishes the queued tasks, then joins
+};
+
+inline ThreadPool::ThreadPool(unsigned threads) : stopping{false} {
+    for (unsigned t = 0; t < std::max(1u, threads); ++t)
+        workers.emplace_back([this] { workerLoop(); });
+}
+
+inline void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> guard{lock};
+            wake.wait(guard, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) return; // stopping, and nothing left to do
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+inline void ThreadPool::enqueue(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> guard{lock};
+        tasks.push_back(std::move(task));
+    }
+    wake.notify_one();
+}
+
+template<typename F>
+auto ThreadPool::submit(F task) -> std::future<decltype(task())> {
+    // std::function needs a copyable callable, so the packaged_task is shared
+    auto packaged = std::make_shared<std::packaged_task<decltype(task())()>>(std::move(task));
+    std::future<decltype(task())> result = packaged->get_future();
+    enqueue([packaged] { (*packaged)(); });
+    return result;
+}
+
+template<typename Body>
+void ThreadPool::run(size_t count, Body body) {
+    if (count == 0) return;
+    if (count == 1) {
+        body(0);
+        return;
+    }
+
+    // Shared with the helper tasks, which may only start after run() has returned
+    struct State {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex lock;
+        std::condition_variable finished;
+        std::exception_ptr error;
+    };
+    auto state = std::make_shared<State>();
+    size_t total = count;
+
+    // Claims indices until none are left to claim
+    auto work = [state, total, &body] {
+        size_t i;
+        while ((i = state->next.fetch_add(1, std::memory_order_relaxed)) < total) {
+            try {
+                body(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> guard{state->lock};
+                if (!state->error) state->error = std::current_exception();
+            }
+            if (state->done.fetch_add(1, std::memory_order_acq_rel) + 1 == total) {
+                std::lock_guard<std::mutex> guard{state->lock};
+                state->finished.notify_all();
+            }
+        }
+    };
+
+    size_t helpers = std::min(size(), count - 1);
+    for (size_t h = 0; h < helpers; ++h) {
+        enqueue(work); // a helper that starts late finds no index left and never touches [body]
+    }
+    work();
+
+    std::unique_lock<std::mutex> guard{state->lock};
+    state->finished.wait(guard, [&] { return state->done.load(std::memory_order_acquire) == total; });
+    if (state->error) std::rethrow_exception(state->error);
+}
+
+inline ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+inline ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard{lock};
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+#endif
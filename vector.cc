@@ -7,26 +7,74 @@
 #define LOG(x)
 #endif
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <filesystem>
+#include <initializer_list>
 #include <iostream>
-
+#include <iterator>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "bulkIO.h"
+#include "growthPolicy.h"
+#include "parallelAlgorithms.h"
+#include "parallelSort.h"
+#include "radixSort.h"
+#include "relocate.h"
+#include "simdKernels.h"
+#include "span.h"
+
+
+// The first N elements live inside the object itself, so short vectors never touch the heap
+template<typename T, size_t N>
+struct InlineStorage {
+    alignas(T) unsigned char buffer[N * sizeof(T)];
+    T* inlineData() { return reinterpret_cast<T*>(buffer); }
+};
 
 template<typename T>
-class Vector {
+struct InlineStorage<T, 0> { // empty base: plain Vectors pay nothing for the inline buffer
+    T* inlineData() { return nullptr; }
+};
+
+template<typename T, size_t N = 0, typename Growth = DoublingGrowth>
+class Vector : InlineStorage<T, N> {
     T* data;
     size_t vecSize;
-    size_t capacity;
+    size_t vecCapacity;
+    std::pmr::memory_resource* resource;
 
         void reallocateMemory(size_t newCap);
+        void grow(size_t required);
+        bool isInline() const { return N > 0 && data == const_cast<Vector*>(this)->inlineData(); }
+        void resetToInline();
     public:
         Vector();
+        explicit Vector(std::pmr::memory_resource* resource); // e.g. a per-request monotonic_buffer_resource
         Vector(const Vector& other);
+        Vector(const Vector& other, std::pmr::memory_resource* resource);
         Vector(Vector&& other);
         Vector& operator=(const Vector& other);
         Vector& operator=(Vector&& other);
         // constexpr: possible to evaluate value at compile-time
         constexpr size_t size() const;
+        constexpr size_t capacity() const;
+        std::pmr::memory_resource* getResource() const;
+        void reserve(size_t newCap);
+        void shrink_to_fit();
+        void resize(size_t newSize);
+        void resize(size_t newSize, const T& value);
         T* getData(); // allows us to memset the memory to a defualt value
         const T* getData() const;
+        Span<T> span() { return Span<T>{data, vecSize}; } // invalidated, like iterators, by reallocation
+        Span<const T> span() const { return Span<const T>{data, vecSize}; }
         T& operator[](size_t index);
         const T& operator[](size_t index) const;
         void push_back(const T& elem);
@@ -36,269 +84,521 @@ class Vector {
         void emplace_back(args&&... myArgs);
         void insert(const T& elem, size_t n);
         void insert(T&& elem, size_t n);
+        template<typename It>
+        void insert(size_t pos, It first, It last); // reallocates and shifts at most once
+        template<typename Range>
+        void append(const Range& range); // any container or span with begin()/end()
+        void append(std::initializer_list<T> values);
         void erase(size_t n);
+        void swap_erase(size_t n); // O(1): moves the last element into the hole, so order is lost
+        template<typename Pred>
+        size_t erase_if(Pred pred); // one compaction pass; returns how many were erased
         void clear();
         T& front();
         const T& front() const;
         T& back();
         const T& back() const;
         bool isEmpty() const;
-        void sort();
+        void sort(); // radix sort for integer and float elements
+        template<typename KeyOf>
+        void sortByKey(KeyOf keyOf); // stable; keyOf(element) returns an integer, float or double
+        void parallelSort(unsigned threads = std::thread::hardware_concurrency());
         void swap(int a, int b);
         typedef T* Iterator; // typedef for std::iterator_traits
         Iterator begin() const { return Iterator{data}; }
         Iterator end() const { return Iterator{data + vecSize}; }
         Iterator rbegin() const { return Iterator{data + vecSize - 1}; }
         Iterator rend() const { return Iterator{data - 1}; }
-        template <typename U>
-        friend std::ostream& operator<<(std::ostream& out, const Vector<U>& v);
+        // Vectorized (AVX-512/AVX2/SSE4.2, picked at runtime) for arithmetic T, plain loops otherwise
+        Iterator find(const T& value) const;
+        size_t count(const T& value) const;
+        bool contains(const T& value) const;
+        T min() const;
+        T max() const;
+        std::pair<T, T> minmax() const;
+        SumType<T> sum() const;
+        SumType<T> dot(const Vector& other) const;
+        // Bulk I/O for integer and float elements: whole buffers at a time, not one operator<< each
+        void writeBinary(const std::string& path, BinaryFormat format = {}) const;
+        void readBinary(const std::string& path, BinaryFormat format = {}); // replaces the contents
+        void writeText(const std::string& path, char separator = '\n') const;
+        void readText(const std::string& path, unsigned threads = 1); // replaces the contents
+        template <typename U, size_t M, typename G>
+        friend std::ostream& operator<<(std::ostream& out, const Vector<U, M, G>& v);
         ~Vector();
 };
 
-template<typename T>
-void Vector<T>::reallocateMemory(size_t newCap) {
-    T* tempData = (T*) ::operator new(sizeof(T) * newCap); // allocates enough memory to hold [newCap] T objects
+template<typename T, size_t N, typename Growth = DoublingGrowth>
+using SmallVector = Vector<T, N, Growth>;
 
-    if (newCap < vecSize) vecSize = newCap;
+template<typename T, size_t N, typename Growth>
+void Vector<T, N, Growth>::reallocateMemory(size_t newCap) {
+    if (newCap < vecSize) {
+        destroyRange(data + newCap, vecSize - newCap);
+        vecSize = newCap;
+    }
 
-    for (size_t i = 0; i < vecSize; ++i)
-        tempData[i] = std::move(data[i]);
+    if (newCap <= N) { // fits in the inline buffer (always false when N == 0 unless newCap is 0)
+        if (!isInline()) {
+            T* heapData = data;
+            data = this->inlineData();
+            if constexpr (N > 0) relocateRange(heapData, vecSize, data); // N == 0 means newCap is 0, so nothing is left to move
+            deallocateBuffer(heapData, vecCapacity, resource);
+        }
+        vecCapacity = N;
+        return;
+    }
 
-    for (size_t i = 0; i < vecSize; ++i)
-        data[i].~T();
+    if (isInline()) { // spilling from the inline buffer to the heap
+        T* heapData = allocateBuffer<T>(newCap, resource);
+        relocateRange(data, vecSize, heapData);
+        data = heapData;
+    } else {
+        // memcpy/realloc for trivially copyable T, move construction otherwise (see relocate.h)
+        data = reallocateBuffer(data, vecSize, vecCapacity, newCap, resource);
+    }
+    vecCapacity = newCap;
+}
 
-    ::operator delete(data, capacity * sizeof(T)); // deallocating mem
-    data = tempData;
-    capacity = newCap;
+template<typename T, size_t N, typename Growth>
+void Vector<T, N, Growth>::grow(size_t required) {
+    reallocateMemory(Growth::grow(vecCapacity, required, sizeof(T)));
 }
 
-template<typename T>
-Vector<T>::Vector() : data{nullptr}, vecSize{0}, capacity{0} {
-    reallocateMemory(1);
+template<typename T, size_t N, typename Growth>
+void Vector<T, N, Growth>::resetToInline() {
+    data = this->inlineData();
+    vecSize = 0;
+    vecCapacity = N;
 }
 
-template<typename T>
-Vector<T>::Vector(const Vector& other) : 
-    data{nullptr}, vecSize{other.size()}, capacity{vecSize} {
-        data = (T*) ::operator new(sizeof(T) * vecSize);
+template<typename T, size_t N, typename Growth>
+Vector<T, N, Growth>::Vector() : Vector{heapResource()} {}
 
-        for (size_t i = 0; i < vecSize; ++i)
-            data[i] = std::move(other[i]);
-    }
+template<typename T, size_t N, typename Growth>
+Vector<T, N, Growth>::Vector(std::pmr::memory_resource* resource) :
+    data{this->inlineData()}, vecSize{0}, vecCapacity{N}, resource{resource} {} // no allocation until the first push
 
-template<typename T>
-Vector<T>::Vector(Vector&& other) : 
-    data{nullptr}, vecSize{other.size()}, capacity{vecSize} {
-        /*
-        data = (T*) ::operator new(sizeof(T) * vecSize);
-
-        for (size_t i = 0; i < vecSize; ++i) {
-            data[i] = std::move(other[i]);
-        }*/
-        data = other.data;
+// Like the std::pmr containers, a copy doesn't inherit the source's resource unless asked to
+template<typename T, size_t N, typename Growth>
+Vector<T, N, Growth>::Vector(const Vector& other) : Vector{other, heapResource()} {}
+
+template<typename T, size_t N, typename Growth>
+Vector<T, N, Growth>::Vector(const Vector& other, std::pmr::memory_resource* resource) :
+    data{this->inlineData()}, vecSize{0}, vecCapacity{N}, resource{resource} {
+        if (other.size() > N) {
+            data = allocateBuffer<T>(other.size(), resource);
+            vecCapacity = other.size();
+        }
 
-        other.data = nullptr;
-        other.capacity = 0;
-        other.vecSize = 0;
+        uninitializedCopy(other.data, other.size(), data);
+        vecSize = other.size();
     }
 
-template<typename T>
-Vector<T>& Vector<T>::operator=(const Vector& other) {
-    for (size_t i = 0; i < vecSize; ++i)
-        data[i].~T();
+template<typename T, size_t N, typename Growth>
+Vector<T, N, Growth>::Vector(Vector&& other) : 
+    data{this->inlineData()}, vecSize{other.size()}, vecCapacity{N}, resource{other.resource} {
+        if (other.isInline()) { // inline elements can't be stolen, so relocate them
+            relocateRange(other.data, vecSize, data);
+        } else {
+            data = other.data;
+            vecCapacity = other.vecCapacity;
+        }
+
+        other.resetToInline();
+    }
 
-    ::operator delete(data, vecSize * sizeof(T)); // deallocating mem
+template<typename T, size_t N, typename Growth>
+Vector<T, N, Growth>& Vector<T, N, Growth>::operator=(const Vector& other) {
+    if (this == &other) return *this;
 
-    vecSize = other.size();
-    capacity = vecSize;
-    
-    data = (T*) ::operator new(sizeof(T) * vecSize);
+    destroyRange(data, vecSize);
+    vecSize = 0;
 
-    for (size_t i = 0; i < vecSize; ++i)
-        data[i] = std::move(other[i]);
+    if (vecCapacity < other.size()) { // reuse the buffer when it's already big enough
+        if (!isInline()) deallocateBuffer(data, vecCapacity, resource);
+        resetToInline();
+        data = allocateBuffer<T>(other.size(), resource);
+        vecCapacity = other.size();
+    }
+
+    uninitializedCopy(other.data, other.size(), data);
+    vecSize = other.size();
 
     return *this;
 }
 
-template<typename T>
-Vector<T>& Vector<T>::operator=(Vector&& other) {
-    std::swap(vecSize, other.vecSize);
-    std::swap(capacity, other.capacity);
-    std::swap(data, other.data);
+template<typename T, size_t N, typename Growth>
+Vector<T, N, Growth>& Vector<T, N, Growth>::operator=(Vector&& other) {
+    if (this == &other) return *this;
+
+    destroyRange(data, vecSize);
+    vecSize = 0;
+
+    if (!other.isInline() && resource->is_equal(*other.resource)) { // steal the buffer
+        if (!isInline()) deallocateBuffer(data, vecCapacity, resource);
+        data = other.data;
+        vecSize = other.vecSize;
+        vecCapacity = other.vecCapacity;
+    } else { // inline elements, or a buffer we can't free through our resource: relocate them
+        if (vecCapacity < other.vecSize) reallocateMemory(other.vecSize);
+        relocateRange(other.data, other.vecSize, data);
+        vecSize = other.vecSize;
+        if (!other.isInline()) deallocateBuffer(other.data, other.vecCapacity, other.resource);
+    }
+
+    other.resetToInline();
 
     return *this;
 }
 
-template<typename T>
-constexpr size_t Vector<T>::size() const { return vecSize; }
+template<typename T, size_t N, typename Growth>
+constexpr size_t Vector<T, N, Growth>::size() const { return vecSize; }
 
-template<typename T>
-T* Vector<T>::getData() { return data; } // allows us to memset the memory to a defualt value
-template<typename T>
-const T* Vector<T>::getData() const { return data; }
+template<typename T, size_t N, typename Growth>
+constexpr size_t Vector<T, N, Growth>::capacity() const { return vecCapacity; }
 
-template<typename T>
-T& Vector<T>::operator[](size_t index) {
+template<typename T, size_t N, typename Growth>
+std::pmr::memory_resource* Vector<T, N, Growth>::getResource() const { return resource; }
+
+template<typename T, size_t N, typename Growth>
+void Vector<T, N, Growth>::reserve(size_t newCap) {
+    if (newCap > vecCapacity) reallocateMemory(newCap); // exact: the caller knows how much it needs
+}
+
+template<typename T, size_t N, typename Growth>
+void Vector<T, N, Growth>::shrink_to_fit() {
+    if (vecSize < vecCapacity) reallocateMemory(vecSize); // moves back inline if it fits
+}
+
+template<typename T, size_t N, typename Growth>
+void Vector<T, N, Growth>::resize(size_t newSize) {
+    if (newSize < vecSize) {
+        destroyRange(data + newSize, vecSize - newSize);
+        vecSize = newSize;
+        return;
+    }
+
+    if (newSize > vecCapacity) grow(newSize);
+    for (; vecSize < newSize; ++vecSize)
+        new(&data[vecSize]) T();
+}
+
+template<typename T, size_t N, typename Growth>
+void Vector<T, N, Growth>::resize(size_t newSize, const T& value) {
+    if (newSize < vecSize) {
+        destroyRange(data + newSize, vecSize - newSize);
+        vecSize = newSize;
+        return;
+    }
+
+    T fill{value}; // [value] may live in this vector and move when we grow
+    if (newSize > vecCapacity) grow(newSize);
+    for (; vecSize < newSize; ++vecSize)
+        new(&data[vecSize]) T(fill);
+}
+
+template<typename T, size_t N, typename Growth>
+T* Vector<T, N, Growth>::getData() { return data; } // allows us to memset the memory to a defualt value
+template<typename T, size_t N, typename Growth>
+const T* Vector<T, N, Growth>::getData() const { return data; }
+
+template<typename T, size_t N, typename Growth>
+T& Vector<T, N, Growth>::operator[](size_t index) {
     assert(index >= 0 && index < vecSize);
     return data[index];
 }
 
-template<typename T>
-const T& Vector<T>::operator[](size_t index) const {
+template<typename T, size_t N, typename Growth>
+const T& Vector<T, N, Growth>::operator[](size_t index) const {
     assert(index >= 0 && index < vecSize);
     return data[index];
 }
 
-template<typename T>
-void Vector<T>::push_back(const T& elem) {
-    if (vecSize == capacity) {
-        reallocateMemory(capacity * 2);
-    }
+template<typename T, size_t N, typename Growth>
+void Vector<T, N, Growth>::push_back(const T& elem) {
+    if (vecSize == vecCapacity) grow(vecSize + 1);
 
-    data[vecSize] = elem;
+    new(&data[vecSize]) T(elem);
     ++vecSize;
 }
 
-template<typename T>
-void Vector<T>::push_back(T&& elem) { // avoids unnecessary copies
-    if (vecSize == capacity) {
-        reallocateMemory(capacity * 2);
-    }
+template<typename T, size_t N, typename Growth>
+void Vector<T, N, Growth>::push_back(T&& elem) { // avoids unnecessary copies
+    if (vecSize == vecCapacity) grow(vecSize + 1);
 
-    data[vecSize] = std::move(elem); // avoids unnecessary copies
+    new(&data[vecSize]) T(std::move(elem)); // avoids unnecessary copies
     ++vecSize;
 }
 
-template<typename T>
-void Vector<T>::pop_back() {
+template<typename T, size_t N, typename Growth>
+void Vector<T, N, Growth>::pop_back() {
     if (vecSize == 0) return;
     --vecSize;
     data[vecSize].~T(); // manually destroy the object
 }
 
-template<typename T>
+template<typename T, size_t N, typename Growth>
 template<typename... args> // variadic template: taking variable # of args
-void Vector<T>::emplace_back(args&&... myArgs) {
-    if (vecSize == capacity) {
-        reallocateMemory(capacity * 2);
-    }
+void Vector<T, N, Growth>::emplace_back(args&&... myArgs) {
+    if (vecSize == vecCapacity) grow(vecSize + 1);
     new(&data[vecSize]) T(std::forward<args>(myArgs)...); //getting location and allocation, writing in directly
     ++vecSize;
 }
 
-template<typename T>
-void Vector<T>::insert(const T& elem, size_t n) {
+template<typename T, size_t N, typename Growth>
+void Vector<T, N, Growth>::insert(const T& elem, size_t n) {
+    insert(T(elem), n); // copy first: [elem] may live in this vector and move when we grow
+}
+
+template<typename T, size_t N, typename Growth>
+void Vector<T, N, Growth>::insert(T&& elem, size_t n) {
     if (n < 0 || n > vecSize) {
         throw std::out_of_range("Invalid index");
     }
-    if (vecSize == capacity) {
-        reallocateMemory(capacity * 2);
-    }
-
-    size_t i = vecSize;
-    while (i > n) {
-        data[i] = std::move(data[i - 1]);
-        --i;
-    }
+    if (vecSize == vecCapacity) grow(vecSize + 1);
 
+    shiftRight(data, vecSize, n, 1); // one memmove for trivially copyable T
+    new(&data[n]) T(std::move(elem));
     ++vecSize;
-    data[i].~T();
-
-    data[i] = elem;
 }
 
-template<typename T>
-void Vector<T>::insert(T&& elem, size_t n) {
-    if (n < 0 || n > vecSize) {
+template<typename T, size_t N, typename Growth>
+template<typename It>
+void Vector<T, N, Growth>::insert(size_t pos, It first, It last) {
+    if (pos > vecSize) {
         throw std::out_of_range("Invalid index");
     }
-    if (vecSize == capacity) {
-        reallocateMemory(capacity * 2);
-    }
 
-    size_t i = vecSize;
-    while (i > n) {
-        data[i] = std::move(data[i - 1]);
-        --i;
+    typedef typename std::iterator_traits<It>::iterator_category Category;
+    if constexpr (!std::is_base_of<std::forward_iterator_tag, Category>::value) { // single pass: can't count first
+        size_t oldSize = vecSize;
+        for (; first != last; ++first) emplace_back(*first);
+        std::rotate(data + pos, data + oldSize, data + vecSize);
+        return;
+    } else {
+        if constexpr (std::is_pointer<It>::value) {
+            if (first < data + vecSize && last > data) { // the range is part of this vector, so it would move under us
+                Vector copy{heapResource()};
+                copy.insert(0, first, last);
+                insert(pos, std::make_move_iterator(copy.begin()), std::make_move_iterator(copy.end()));
+                return;
+            }
+        }
+
+        size_t count = (size_t) std::distance(first, last);
+        if (count == 0) return;
+
+        if (vecSize + count > vecCapacity) { // build the new buffer around the range, then relocate into it
+            size_t newCap = Growth::grow(vecCapacity, vecSize + count, sizeof(T));
+            T* fresh = allocateBuffer<T>(newCap, resource);
+            try {
+                uninitializedCopy(first, count, fresh + pos);
+            } catch (...) {
+                deallocateBuffer(fresh, newCap, resource);
+                throw;
+            }
+
+            relocateRange(data, pos, fresh);
+            relocateRange(data + pos, vecSize - pos, fresh + pos + count);
+            if (!isInline()) deallocateBuffer(data, vecCapacity, resource);
+            data = fresh;
+            vecCapacity = newCap;
+        } else {
+            shiftRight(data, vecSize, pos, count); // one memmove for trivially copyable T
+            try {
+                uninitializedCopy(first, count, data + pos);
+            } catch (...) {
+                shiftLeft(data, vecSize + count, pos, count);
+                throw;
+            }
+        }
+        vecSize += count;
     }
+}
 
-    ++vecSize;
-    data[i].~T();
+template<typename T, size_t N, typename Growth>
+template<typename Range>
+void Vector<T, N, Growth>::append(const Range& range) {
+    insert(vecSize, std::begin(range), std::end(range));
+}
 
-    data[i] = std::move(elem);
+template<typename T, size_t N, typename Growth>
+void Vector<T, N, Growth>::append(std::initializer_list<T> values) {
+    insert(vecSize, values.begin(), values.end());
 }
 
-template<typename T>
-void Vector<T>::erase(size_t n) {
+template<typename T, size_t N, typename Growth>
+void Vector<T, N, Growth>::erase(size_t n) {
     if (n < 0 || n >= vecSize) {
         throw std::out_of_range("Invalid index");
     }
 
-    size_t i = 0;
-    while (i < n) ++i;
-
+    data[n].~T();
+    shiftLeft(data, vecSize, n, 1); // one memmove for trivially copyable T
     --vecSize;
-    data[i].~T();
+}
 
-    while (i < vecSize) {
-        data[i] = std::move(data[i + 1]);
-        ++i;
+template<typename T, size_t N, typename Growth>
+void Vector<T, N, Growth>::swap_erase(size_t n) {
+    if (n >= vecSize) {
+        throw std::out_of_range("Invalid index");
     }
 
-    data[vecSize].~T();
+    if (n != vecSize - 1) data[n] = std::move(data[vecSize - 1]);
+    data[vecSize - 1].~T();
+    --vecSize;
 }
 
-template<typename T>
-void Vector<T>::clear() {
+template<typename T, size_t N, typename Growth>
+template<typename Pred>
+size_t Vector<T, N, Growth>::erase_if(Pred pred) {
+    size_t kept = 0;
     for (size_t i = 0; i < vecSize; ++i) {
-        data[i].~T();
+        if (pred(data[i])) continue;
+        if (kept != i) data[kept] = std::move(data[i]);
+        ++kept;
     }
 
-    vecSize = 0;
-    reallocateMemory(1);
+    size_t erased = vecSize - kept;
+    destroyRange(data + kept, erased);
+    vecSize = kept;
+    return erased;
 }
 
-template<typename T>
-T& Vector<T>::front() {
+template<typename T, size_t N, typename Growth>
+void Vector<T, N, Growth>::clear() {
+    destroyRange(data, vecSize);
+
+    vecSize = 0; // keeps the buffer so a reused vector doesn't grow all over again; see shrink_to_fit
+}
+
+template<typename T, size_t N, typename Growth>
+T& Vector<T, N, Growth>::front() {
     if (vecSize == 0) throw std::out_of_range("Empty array");
     return data[0];
 }
 
-template<typename T>
-const T& Vector<T>::front() const {
+template<typename T, size_t N, typename Growth>
+const T& Vector<T, N, Growth>::front() const {
     if (vecSize == 0) throw std::out_of_range("Empty array");
     return data[0];
 }
 
-template<typename T>
-T& Vector<T>::back() {
+template<typename T, size_t N, typename Growth>
+T& Vector<T, N, Growth>::back() {
     if (vecSize == 0) throw std::out_of_range("Empty array");
     return data[vecSize - 1];
 }
 
-template<typename T>
-const T& Vector<T>::back() const {
+template<typename T, size_t N, typename Growth>
+const T& Vector<T, N, Growth>::back() const {
     if (vecSize == 0) throw std::out_of_range("Empty array");
     return data[vecSize - 1];
 }
 
-template<typename T>
-bool Vector<T>::isEmpty() const {
+template<typename T, size_t N, typename Growth>
+bool Vector<T, N, Growth>::isEmpty() const {
     return vecSize == 0;
 }
 
-template<typename T>
-void Vector<T>::sort() {
-    std::sort(begin(), end());
+template<typename T, size_t N, typename Growth>
+void Vector<T, N, Growth>::sort() {
+    sortRange(begin(), end());
 }
 
-template<typename T>
-void Vector<T>::swap(int a, int b) {
+template<typename T, size_t N, typename Growth>
+template<typename KeyOf>
+void Vector<T, N, Growth>::sortByKey(KeyOf keyOf) {
+    radixSortByKey(begin(), end(), keyOf);
+}
+
+template<typename T, size_t N, typename Growth>
+void Vector<T, N, Growth>::parallelSort(unsigned threads) { // falls back to sort() for small arrays
+    ::parallelSort(begin(), end(), threads);
+}
+
+template<typename T, size_t N, typename Growth>
+typename Vector<T, N, Growth>::Iterator Vector<T, N, Growth>::find(const T& value) const {
+    return begin() + simdFind(data, vecSize, value);
+}
+
+template<typename T, size_t N, typename Growth>
+size_t Vector<T, N, Growth>::count(const T& value) const {
+    return simdCount(data, vecSize, value);
+}
+
+template<typename T, size_t N, typename Growth>
+bool Vector<T, N, Growth>::contains(const T& value) const {
+    return simdFind(data, vecSize, value) != vecSize;
+}
+
+template<typename T, size_t N, typename Growth>
+T Vector<T, N, Growth>::min() const {
+    return minmax().first;
+}
+
+template<typename T, size_t N, typename Growth>
+T Vector<T, N, Growth>::max() const {
+    return minmax().second;
+}
+
+template<typename T, size_t N, typename Growth>
+std::pair<T, T> Vector<T, N, Growth>::minmax() const {
+    if (vecSize == 0) throw std::out_of_range("Empty array");
+    return simdMinMax(data, vecSize);
+}
+
+template<typename T, size_t N, typename Growth>
+SumType<T> Vector<T, N, Growth>::sum() const {
+    return simdSum(data, vecSize);
+}
+
+template<typename T, size_t N, typename Growth>
+SumType<T> Vector<T, N, Growth>::dot(const Vector& other) const {
+    if (other.vecSize != vecSize) throw std::invalid_argument("Size mismatch");
+    return simdDot(data, other.data, vecSize);
+}
+
+template<typename T, size_t N, typename Growth>
+void Vector<T, N, Growth>::writeBinary(const std::string& path, BinaryFormat format) const {
+    ::writeBinary(path, span(), format);
+}
+
+template<typename T, size_t N, typename Growth>
+void Vector<T, N, Growth>::readBinary(const std::string& path, BinaryFormat format) {
+    Vector loaded{resource}; // read into a fresh buffer so a failed read leaves this vector as it was
+    ::readBinary<T>(path, format, [&loaded](size_t count) {
+        loaded.reserve(count);
+        loaded.vecSize = count;
+        return loaded.data;
+    });
+    *this = std::move(loaded);
+}
+
+template<typename T, size_t N, typename Growth>
+void Vector<T, N, Growth>::writeText(const std::string& path, char separator) const {
+    ::writeText(path, span(), separator);
+}
+
+template<typename T, size_t N, typename Growth>
+void Vector<T, N, Growth>::readText(const std::string& path, unsigned threads) {
+    Vector loaded{resource};
+    ::readText<T>(path, threads, [&loaded](size_t count) {
+        loaded.reserve(count);
+        loaded.vecSize = count;
+        return loaded.data;
+    });
+    *this = std::move(loaded);
+}
+
+template<typename T, size_t N, typename Growth>
+void Vector<T, N, Growth>::swap(int a, int b) {
     std::swap(data[a], data[b]);
 }
 
-template<typename T>
-std::ostream& operator<<(std::ostream& out, const Vector<T>& v) {
+template<typename T, size_t N, typename Growth>
+std::ostream& operator<<(std::ostream& out, const Vector<T, N, Growth>& v) {
     out << "{";
     for (size_t i = 0; i < v.vecSize; ++i) {
         out << v[i];
@@ -308,11 +608,10 @@ std::ostream& operator<<(std::ostream& out, const Vector<T>& v) {
     return out;
 }
 
-template<typename T>
-Vector<T>::~Vector() {
-    clear();
-
-    ::operator delete(data, capacity * sizeof(T)); // deallocating mem
+template<typename T, size_t N, typename Growth>
+Vector<T, N, Growth>::~Vector() {
+    destroyRange(data, vecSize);
+    if (!isInline()) deallocateBuffer(data, vecCapacity, resource);
 }
 
 Vector<std::string> getNewVec() {
@@ -392,6 +691,148 @@ void testVectorClass() {
 
     Vector<std::string> v5{getNewVec()};
     std::cout << v5;
+
+    Vector<int> numbers; // trivially copyable: grows with realloc, shifts with memmove
+    for (int i = 0; i < 10; ++i) numbers.push_back(i);
+    numbers.insert(100, 3);
+    numbers.erase(0);
+    numbers.erase(numbers.size() - 1);
+    std::cout << numbers;
+
+    SmallVector<std::string, 4> team; // spills to the heap on the 5th element
+    team.push_back("Ada");
+    team.emplace_back("Grace");
+    team.insert("Linus", 0);
+    std::cout << team;
+    team.emplace_back("Bjarne");
+    team.emplace_back("Dennis");
+    team.erase(1);
+    std::cout << team;
+
+    SmallVector<std::string, 4> teamCopy{team};
+    SmallVector<std::string, 4> teamMoved{std::move(team)};
+    std::cout << teamCopy << teamMoved;
+    teamMoved = std::move(teamCopy); // teamCopy still fits inline, so its elements are relocated
+    for (auto& member : teamMoved) LOG(member)
+
+    Vector<int, 0, OneAndHalfGrowth> batch;
+    batch.reserve(8);
+    for (int round = 0; round < 3; ++round) { // clear() keeps the buffer, so only round 0 grows
+        batch.clear();
+        for (int i = 0; i < 20; ++i) batch.push_back(round * 100 + i);
+        LOG("Round " << round << ": size " << batch.size() << ", capacity " << batch.capacity())
+    }
+    batch.resize(5);
+    batch.resize(7, -1);
+    batch.shrink_to_fit();
+    std::cout << batch;
+    LOG("Capacity after shrink_to_fit: " << batch.capacity())
+
+    Vector<double, 0, FixedStepGrowth<16>> samples;
+    for (int i = 0; i < 17; ++i) samples.emplace_back(i * 0.5);
+    LOG("Fixed-step capacity: " << samples.capacity())
+
+    Vector<char, 0, PageRoundedGrowth<>> pageBuffer;
+    pageBuffer.resize(5000);
+    LOG("Page-rounded capacity: " << pageBuffer.capacity())
+
+    char arena[1024];
+    std::pmr::monotonic_buffer_resource requestArena{arena, sizeof(arena)};
+    Vector<std::string> guests{&requestArena}; // every buffer comes out of the arena
+    guests.emplace_back("Pat");
+    guests.emplace_back("Sam");
+    guests.emplace_back("Kim");
+    Vector<std::string> heapGuests;
+    heapGuests = std::move(guests); // different resources: elements are relocated, not stolen
+    std::cout << heapGuests;
+
+    Vector<int> records;
+    for (int i = 0; i < 1000000; ++i) records.push_back((int) (((long long) i * 7919) % 1000003));
+    std::vector<int> recordsReference(records.begin(), records.end());
+    std::sort(recordsReference.begin(), recordsReference.end());
+    records.parallelSort(8);
+    LOG("Parallel sort matches std::sort: " << std::equal(records.begin(), records.end(), recordsReference.begin(), recordsReference.end()))
+
+    Vector<std::string> names; // not trivially copyable: moved-from strings would show up as empty
+    for (int i = 0; i < 400000; ++i) names.push_back(std::to_string((i * 31) % 400000));
+    std::vector<std::string> namesReference(names.begin(), names.end());
+    std::sort(namesReference.begin(), namesReference.end());
+    names.parallelSort(5); // an odd run is carried over unmerged in the first round
+    LOG("Parallel sort matches std::sort for strings: " << std::equal(names.begin(), names.end(), namesReference.begin(), namesReference.end()))
+
+    Vector<std::string> labels; // long enough to live on the heap, so a leaked element would show up
+    for (int i = 0; i < 100000; ++i) labels.push_back("shipment-label-" + std::to_string((i * 31) % 100000));
+    std::atomic<long> comparisonsLeft{1920000}; // runs out in the first merge round, while scratch is raw memory
+    try {
+        ::parallelSort(labels.begin(), labels.end(), 3, [&](const std::string& a, const std::string& b) {
+            if (comparisonsLeft.fetch_sub(1, std::memory_order_relaxed) <= 0) throw std::runtime_error("Comparator failed");
+            return a < b;
+        });
+    } catch (const std::runtime_error& e) {
+        LOG("Parallel sort rethrew: " << e.what() << ", labels kept: " << labels.size())
+    }
+
+    Vector<float> readings;
+    for (int i = 0; i < 100000; ++i) readings.push_back((float) ((i * 7919) % 100003 - 50000) / 7);
+    readings.sort(); // radix sort: negative floats need their bits flipped
+    LOG("Radix sort sorted floats: " << std::is_sorted(readings.begin(), readings.end()))
+
+    Vector<std::pair<long long, int>> events;
+    for (int i = 0; i < 5000; ++i) events.emplace_back((i * 37) % 100 - 50, i);
+    events.sortByKey([](const std::pair<long long, int>& event) { return event.first; });
+    LOG("Sort by key sorted: " << std::is_sorted(events.begin(), events.end())) // stable, so ties keep their order
+
+    Vector<int> scores;
+    for (int i = 0; i < 1000; ++i) scores.push_back((i * 37) % 101);
+    LOG("Found 42 at: " << scores.find(42) - scores.begin() << ", count: " << scores.count(42) << ", contains 101: " << scores.contains(101))
+    LOG("Min: " << scores.min() << ", max: " << scores.max() << ", sum: " << scores.sum() << ", dot: " << scores.dot(scores))
+    LOG("Min name: " << studentList.minmax().first) // non-arithmetic T uses the scalar loops
+
+    Vector<int> ids;
+    for (int i = 0; i < 20; ++i) ids.push_back(i);
+    LOG("Erased odd ids: " << ids.erase_if([](int id) { return id % 2 == 1; }))
+    ids.swap_erase(0); // 18 takes 0's place
+    std::cout << ids;
+
+    int extra[] = {100, 101, 102};
+    ids.insert(2, extra, extra + 3);
+    ids.insert(0, ids.begin() + 2, ids.begin() + 4); // a range from inside the vector itself
+    ids.append({7, 8, 9});
+    std::cout << ids;
+
+    SmallVector<std::string, 2> tags; // range insert spilling out of the inline buffer
+    tags.append(studentList);
+    tags.insert(1, studentList.begin(), studentList.begin() + 2);
+    std::cout << tags;
+
+    Span<int> window = scores.span().subspan(100, 500); // no copy: a view into scores
+    long long windowSum = window.sum();
+    window.sort();
+    LOG("Window sorted: " << std::is_sorted(scores.begin() + 100, scores.begin() + 600) << ", sum unchanged: " << (window.sum() == windowSum))
+    size_t chunkTotal = 0;
+    for (Span<const int> chunk : Span<const int>{window}.split(3)) chunkTotal += chunk.count(42);
+    LOG("Count of 42 over three chunks: " << chunkTotal << " == " << window.count(42))
+    StridedSpan<int> everyTenth = scores.span().strided(10);
+    LOG("Every tenth: " << everyTenth.size() << " elements, max " << everyTenth.max() << ", sum " << everyTenth.sum())
+
+    std::string path = (std::filesystem::temp_directory_path() / "vector.test.bin").string();
+    readings.writeBinary(path, BinaryFormat{true, Endian::Big}); // count-prefixed, big-endian on disk
+    Vector<float> reloaded;
+    reloaded.readBinary(path, BinaryFormat{true, Endian::Big});
+    LOG("Binary round trip: " << reloaded.size() << " floats, equal: " << std::equal(reloaded.begin(), reloaded.end(), readings.begin()))
+
+    records.writeText(path);
+    Vector<int> parsed;
+    parsed.readText(path, 4); // four threads, each parsing a quarter of the file
+    LOG("Text round trip: " << parsed.size() << " ints, equal: " << std::equal(parsed.begin(), parsed.end(), records.begin()))
+    std::filesystem::remove(path);
+
+    Vector<double> scores2;
+    scores2.resize(records.size());
+    parallelTransform(records.span(), scores2.span(), [](int record) { return record * 0.001; }); // on the shared pool
+    double total = parallelReduce(scores2.span(), 0.0);
+    long long hits = parallelTransformReduce(records.span(), 0LL, std::plus<>{}, [](int record) { return record % 7 == 0 ? 1LL : 0LL; }, Schedule::Dynamic);
+    LOG("Scored " << scores2.size() << " records, total " << (long long) total << ", multiples of 7: " << hits)
 }
 
 int main() {
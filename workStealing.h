@@ -0,0 +1,376 @@
+// C++ Data Structures
+
+#ifndef WORK_STEALING_H
+#define WORK_STEALING_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/* Work Stealing
+- WorkStealingDeque is a Chase-Lev deque. One owner thread pushes and pops at the bottom without
+  locks or read-modify-writes in the common case; any number of thieves steal from the top with a
+  CAS. Only a pop that races a steal for the last element needs a CAS
+- The deque's ring buffer doubles when full. Old buffers stay alive until the deque is destroyed,
+  since a thief may still be reading one (they total less than the current buffer)
+- Elements must be trivially copyable, because thieves read them with plain atomic loads; the
+  scheduler stores Task pointers
+- WorkStealingScheduler gives every worker its own deque. Tasks spawned from a worker go onto its
+  deque and are popped newest first (depth first, cache warm); idle workers steal the oldest
+  tasks of a random victim, which are usually the largest pieces of a fork-join tree
+- TaskGroup spawns tasks and waits for them. A waiting thread runs other tasks instead of
+  blocking, so nested fork-join never deadlocks
+- forkJoinFor splits an index range in halves down to a grain size, for recursive parallelism
+*/
+
+template<typename T>
+class WorkStealingDeque {
+    static_assert(std::is_trivially_copyable<T>::value, "Work-stealing deque elements must be trivially copyable");
+
+    struct Buffer {
+        int64_t capacity; // a power of two
+        std::unique_ptr<std::atomic<T>[]> slots;
+
+        explicit Buffer(int64_t capacity) : capacity{capacity}, slots{new std::atomic<T>[capacity]} {}
+        T get(int64_t i) const { return slots[i & (capacity - 1)].load(std::memory_order_relaxed); }
+        void put(int64_t i, T value) { slots[i & (capacity - 1)].store(value, std::memory_order_relaxed); }
+    };
+
+    alignas(64) std::atomic<int64_t> top; // thieves' end
+    alignas(64) std::atomic<int64_t> bottom; // owner's end
+    std::atomic<Buffer*> buffer;
+    std::vector<std::unique_ptr<Buffer>> buffers; // the current one and every one it replaced; owner only
+
+        Buffer* grow(Buffer* old, int64_t from, int64_t to);
+    public:
+        explicit WorkStealingDeque(size_t capacity = 256);
+        WorkStealingDeque(const WorkStealingDeque& other) = delete;
+        WorkStealingDeque& operator=(const WorkStealingDeque& other) = delete;
+        void push(T value); // owner only
+        bool pop(T& out); // owner only: newest first
+        bool steal(T& out); // any thread: oldest first. False if empty or another thread won the race
+        size_t size() const; // a snapshot
+        bool isEmpty() const { return size() == 0; }
+};
+
+template<typename T>
+WorkStealingDeque<T>::WorkStealingDeque(size_t capacity) : top{0}, bottom{0} {
+    int64_t rounded = 1;
+    while (rounded < (int64_t) capacity) rounded <<= 1;
+    buffers.push_back(std::make_unique<Buffer>(rounded));
+    buffer.store(buffers.back().get(), std::memory_order_relaxed);
+}
+
+template<typename T>
+typename WorkStealingDeque<T>::Buffer* WorkStealingDeque<T>::grow(Buffer* old, int64_t from, int64_t to) {
+    buffers.push_back(std::make_unique<Buffer>(old->capacity * 2));
+    Buffer* bigger = buffers.back().get();
+    for (int64_t i = from; i < to; ++i) bigger->put(i, old->get(i)); // same indices, so top and bottom stay valid
+    buffer.store(bigger, std::memory_order_release);
+    return bigger;
+}
+
+template<typename T>
+void WorkStealingDeque<T>::push(T value) {
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    Buffer* a = buffer.load(std::memory_order_relaxed);
+    if (b - t > a->capacity - 1) a = grow(a, t, b);
+    a->put(b, value);
+    bottom.store(b + 1, std::memory_order_release); // the element is visible before the new bottom
+}
+
+template<typename T>
+bool WorkStealingDeque<T>::pop(T& out) {
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    Buffer* a = buffer.load(std::memory_order_relaxed);
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst); // claim [b] before looking at top
+    int64_t t = top.load(std::memory_order_relaxed);
+
+    if (t > b) { // was empty
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    out = a->get(b);
+    if (t < b) return true; // more than one left, so no thief can reach [b]
+
+    // The last element: race the thieves for it
+    bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return won;
+}
+
+template<typename T>
+bool WorkStealingDeque<T>::steal(T& out) {
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b) return false;
+
+    Buffer* a = buffer.load(std::memory_order_acquire);
+    T value = a->get(t);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return false; // the owner or another thief took it
+    out = value;
+    return true;
+}
+
+template<typename T>
+size_t WorkStealingDeque<T>::size() const {
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_relaxed);
+    return b > t ? (size_t) (b - t) : 0;
+}
+
+class TaskGroup;
+
+class WorkStealingScheduler {
+    struct Task {
+        std::function<void()> body;
+        TaskGroup* group;
+    };
+
+    struct alignas(64) Worker {
+        WorkStealingDeque<Task*> deque;
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::deque<Task*> injected; // tasks spawned from outside the pool
+    std::mutex lock; // guards [injected] and [stopping]
+    std::condition_variable wake;
+    std::atomic<int64_t> pending; // spawned but not yet taken; a hint for idle workers
+    std::atomic<int> sleepers;
+    bool stopping;
+
+    static constexpr int idleSpins = 64; // failed searches before a worker sleeps
+
+        static WorkStealingScheduler*& currentScheduler();
+        static size_t& currentWorker();
+        static uint32_t randomNumber();
+        void schedule(Task* task);
+        Task* findTask();
+        void execute(Task* task);
+        void workerLoop(size_t index);
+        friend class TaskGroup;
+    public:
+        explicit WorkStealingScheduler(unsigned threads = std::max(1u, std::thread::hardware_concurrency()));
+        WorkStealingScheduler(const WorkStealingScheduler& other) = delete;
+        WorkStealingScheduler& operator=(const WorkStealingScheduler& other) = delete;
+        size_t size() const { return workers.size(); }
+        static WorkStealingScheduler& shared();
+        ~WorkStealingScheduler(); // every TaskGroup must have finished waiting by now
+};
+
+class TaskGroup {
+    WorkStealingScheduler& scheduler;
+    std::atomic<size_t> outstanding;
+    std::mutex errorLock;
+    std::exception_ptr error;
+
+        void finish(std::exception_ptr taskError);
+        friend class WorkStealingScheduler;
+    public:
+        explicit TaskGroup(WorkStealingScheduler& scheduler = WorkStealingScheduler::shared()) : scheduler{scheduler}, outstanding{0} {}
+        TaskGroup(const TaskGroup& other) = delete;
+        TaskGroup& operator=(const TaskGroup& other) = delete;
+        template<typename F>
+        void spawn(F task); // may be called from inside the group's own tasks
+        void wait(); // runs queued tasks until the group is done, then rethrows the first exception
+        ~TaskGroup(); // waits, dropping any exception
+};
+
+inline WorkStealingScheduler*& WorkStealingScheduler::currentScheduler() {
+    thread_local WorkStealingScheduler* scheduler = nullptr;
+    return scheduler;
+}
+
+inline size_t& WorkStealingScheduler::currentWorker() {
+    thread_local size_t index = 0;
+    return index;
+}
+
+inline uint32_t WorkStealingScheduler::randomNumber() {
+    thread_local uint32_t seed = (uint32_t) std::hash<std::thread::id>{}(std::this_thread::get_id()) | 1;
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+inline WorkStealingScheduler::WorkStealingScheduler(unsigned threads) : pending{0}, sleepers{0}, stopping{false} {
+    for (unsigned t = 0; t < std::max(1u, threads); ++t) workers.push_back(std::make_unique<Worker>());
+    for (size_t i = 0; i < workers.size(); ++i) // started once every deque exists, since they steal from each other
+        workers[i]->thread = std::thread([this, i] { workerLoop(i); });
+}
+
+inline void WorkStealingScheduler::schedule(Task* task) {
+    pending.fetch_add(1, std::memory_order_seq_cst); // before the push, so a taker never drives it negative
+    if (currentScheduler() == this) {
+        workers[currentWorker()]->deque.push(task);
+    } else {
+        std::lock_guard<std::mutex> guard{lock};
+        injected.push_back(task);
+    }
+
+    if (sleepers.load(std::memory_order_seq_cst) > 0) { // pairs with the sleepers increment in workerLoop
+        std::lock_guard<std::mutex> guard{lock};
+        wake.notify_one();
+    }
+}
+
+inline WorkStealingScheduler::Task* WorkStealingScheduler::findTask() {
+    Task* task = nullptr;
+    bool isWorker = currentScheduler() == this;
+    if (isWorker && workers[currentWorker()]->deque.pop(task)) {
+        pending.fetch_sub(1, std::memory_order_relaxed);
+        return task;
+    }
+
+    {
+        std::unique_lock<std::mutex> guard{lock, std::try_to_lock};
+        if (guard.owns_lock() && !injected.empty()) {
+            task = injected.front();
+            injected.pop_front();
+            pending.fetch_sub(1, std::memory_order_relaxed);
+            return task;
+        }
+    }
+
+    size_t start = randomNumber() % workers.size();
+    for (size_t k = 0; k < workers.size(); ++k) {
+        size_t victim = (start + k) % workers.size();
+        if (isWorker && victim == currentWorker()) continue;
+        if (workers[victim]->deque.steal(task)) {
+            pending.fetch_sub(1, std::memory_order_relaxed);
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+inline void WorkStealingScheduler::execute(Task* task) {
+    std::exception_ptr taskError;
+    try {
+        task->body();
+    } catch (...) {
+        taskError = std::current_exception();
+    }
+    TaskGroup* group = task->group;
+    delete task;
+    group->finish(taskError); // last: the group may be destroyed as soon as it sees zero
+}
+
+inline void WorkStealingScheduler::workerLoop(size_t index) {
+    currentScheduler() = this;
+    currentWorker() = index;
+
+    int idle = 0;
+    while (true) {
+        if (Task* task = findTask()) {
+            execute(task);
+            idle = 0;
+            continue;
+        }
+        if (++idle < idleSpins) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        sleepers.fetch_add(1, std::memory_order_seq_cst);
+        {
+            std::unique_lock<std::mutex> guard{lock};
+            wake.wait(guard, [this] { return stopping || pending.load(std::memory_order_seq_cst) > 0; });
+        }
+        sleepers.fetch_sub(1, std::memory_order_relaxed);
+        idle = 0;
+
+        std::lock_guard<std::mutex> guard{lock};
+        if (stopping && injected.empty()) return;
+    }
+}
+
+inline WorkStealingScheduler& WorkStealingScheduler::shared() {
+    static WorkStealingScheduler scheduler;
+    return scheduler;
+}
+
+inline WorkStealingScheduler::~WorkStealingScheduler() {
+    {
+        std::lock_guard<std::mutex> guard{lock};
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) worker->thread.join();
+}
+
+inline void TaskGroup::finish(std::exception_ptr taskError) {
+    if (taskError) {
+        std::lock_guard<std::mutex> guard{errorLock};
+        if (!error) error = taskError;
+    }
+    outstanding.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+template<typename F>
+void TaskGroup::spawn(F task) {
+    auto* job = new WorkStealingScheduler::Task{std::function<void()>(std::move(task)), this};
+    outstanding.fetch_add(1, std::memory_order_relaxed);
+    scheduler.schedule(job);
+}
+
+inline void TaskGroup::wait() {
+    while (outstanding.load(std::memory_order_acquire) > 0) {
+        if (WorkStealingScheduler::Task* task = scheduler.findTask()) scheduler.execute(task); // help rather than block
+        else std::this_thread::yield();
+    }
+
+    std::lock_guard<std::mutex> guard{errorLock};
+    if (error) {
+        std::exception_ptr thrown = error;
+        error = nullptr;
+        std::rethrow_exception(thrown);
+    }
+}
+
+inline TaskGroup::~TaskGroup() {
+    try {
+        wait();
+    } catch (...) {
+    }
+}
+
+// body(i) for every i in [first, last), split in halves down to [grain] indices per task
+template<typename Body>
+void forkJoinFor(size_t first, size_t last, size_t grain, Body body, WorkStealingScheduler& scheduler = WorkStealingScheduler::shared()) {
+    // Declared before [group], whose destructor still runs queued tasks that call it when body throws here
+    std::function<void(size_t, size_t)> split;
+    TaskGroup group{scheduler};
+    grain = std::max<size_t>(1, grain);
+
+    split = [&](size_t from, size_t to) {
+        while (to - from > grain) { // keep the lower half, hand the upper half to a thief
+            size_t mid = from + (to - from) / 2;
+            group.spawn([&split, mid, to] { split(mid, to); });
+            to = mid;
+        }
+        for (size_t i = from; i < to; ++i) body(i);
+    };
+    split(first, last);
+    group.wait();
+}
+
+#endif